@@ -42,7 +42,12 @@ SoundTouchAudioSource::SoundTouchAudioSource (PositionableAudioSource* source_,
       numberOfChannels (numberOfChannels_),
       buffer (numberOfChannels_, 0),
       nextReadPos (0),
-      isPrepared (false)
+      isPrepared (false),
+      backgroundThread (nullptr),
+      fifo (1),
+      fifoBuffer (numberOfChannels_, 1),
+      lookahead (0),
+      requestedPosition (0)
 {
     jassert (source_ != nullptr);
 
@@ -51,6 +56,7 @@ SoundTouchAudioSource::SoundTouchAudioSource (PositionableAudioSource* source_,
 
 SoundTouchAudioSource::~SoundTouchAudioSource()
 {
+    setBackgroundThread (nullptr);
     releaseResources();
 }
 
@@ -62,6 +68,12 @@ void SoundTouchAudioSource::setPlaybackSettings (SoundTouchProcessor::PlaybackSe
 //==============================================================================
 void SoundTouchAudioSource::prepareToPlay (int /*samplesPerBlockExpected*/, double sampleRate_)
 {
+    // (the background thread mustn't be rendering while the processor's reset)
+    TimeSliceThread* const thread = backgroundThread;
+    
+    if (thread != nullptr)
+        thread->removeTimeSliceClient (this);
+    
     soundTouchProcessor.initialise (numberOfChannels, sampleRate);
     
     if (sampleRate_ != sampleRate
@@ -74,21 +86,41 @@ void SoundTouchAudioSource::prepareToPlay (int /*samplesPerBlockExpected*/, doub
         
         source->prepareToPlay (numberOfSamplesToBuffer, sampleRate_);
     }
+    
+    if (thread != nullptr)
+        thread->addTimeSliceClient (this);
 }
 
 void SoundTouchAudioSource::releaseResources()
 {
+    TimeSliceThread* const thread = backgroundThread;
+    
+    if (thread != nullptr)
+        thread->removeTimeSliceClient (this);
+    
     soundTouchProcessor.clear();
     
     isPrepared = false;
     
     source->releaseResources();
+    
+    if (thread != nullptr)
+        thread->addTimeSliceClient (this);
 }
 
 void SoundTouchAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
 {
+    if (backgroundThread != nullptr)
+    {
+        readFromFifo (info);
+        return;
+    }
+    
     while (soundTouchProcessor.getNumReady() < info.numSamples)
+    {
+        const ScopedLock sl (bufferStartPosLock);
         readNextBufferChunk();
+    }
 
     soundTouchProcessor.readSamples (info.buffer->getArrayOfChannels(), buffer.getNumChannels(),
                                      info.numSamples, info.startSample);
@@ -99,6 +131,15 @@ void SoundTouchAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& inf
 //==============================================================================
 void SoundTouchAudioSource::setNextReadPosition (int64 newPosition)
 {
+    if (backgroundThread != nullptr)
+    {
+        // the background thread renders from the new position (see useTimeSlice)
+        effectiveNextPlayPos = newPosition;
+        requestedPosition = newPosition;
+        positionChange = positionRequested;
+        return;
+    }
+    
     const ScopedLock sl (bufferStartPosLock);
 
     nextReadPos = effectiveNextPlayPos = newPosition;
@@ -115,8 +156,6 @@ int64 SoundTouchAudioSource::getNextReadPosition() const
 //==============================================================================
 void SoundTouchAudioSource::readNextBufferChunk()
 {
-    const ScopedLock sl (bufferStartPosLock);
-
     if (source->getNextReadPosition() != nextReadPos)
         source->setNextReadPosition (nextReadPos);
     
@@ -131,5 +170,147 @@ void SoundTouchAudioSource::readNextBufferChunk()
     soundTouchProcessor.writeSamples (buffer.getArrayOfChannels(), buffer.getNumChannels(), info.numSamples);
 }
 
+//==============================================================================
+void SoundTouchAudioSource::setBackgroundThread (TimeSliceThread* thread, int lookaheadSamples)
+{
+    if (backgroundThread != nullptr)
+        backgroundThread->removeTimeSliceClient (this);
+    
+    {
+        const ScopedLock sl (bufferStartPosLock);
+        
+        // (a position change the background thread hasn't rendered from yet)
+        if (backgroundThread != nullptr && positionChange.get() != positionUnchanged)
+        {
+            nextReadPos = requestedPosition.get();
+            soundTouchProcessor.clear();
+        }
+        
+        backgroundThread = nullptr;
+        lookahead = jmax (1024, lookaheadSamples);
+        
+        // one extra block of space, as SoundTouch output arrives in chunks
+        fifo.setTotalSize (lookahead + numberOfSamplesToBuffer + 1);
+        fifo.reset();
+        fifoBuffer.setSize (numberOfChannels, fifo.getTotalSize());
+        fifoBuffer.clear();
+        
+        positionChange = positionUnchanged;
+        numUnderruns = 0;
+        minimumSamplesAhead = lookahead;
+        
+        backgroundThread = thread;
+    }
+    
+    if (backgroundThread != nullptr)
+        backgroundThread->addTimeSliceClient (this);
+}
+
+float SoundTouchAudioSource::getLookaheadFillLevel() const
+{
+    return lookahead > 0 ? jmin (1.0f, fifo.getNumReady() / (float) lookahead) : 0.0f;
+}
+
+float SoundTouchAudioSource::getAndResetMinimumFillLevel()
+{
+    return lookahead > 0 ? jmin (1.0f, minimumSamplesAhead.exchange (fifo.getNumReady()) / (float) lookahead) : 0.0f;
+}
+
+int SoundTouchAudioSource::getIdleTimeMs() const
+{
+    // about a quarter of the lookahead, so it's topped up long before it runs out
+    return sampleRate > 0 ? jlimit (1, 20, (int) (lookahead * 250 / sampleRate)) : 5;
+}
+
+int SoundTouchAudioSource::useTimeSlice()
+{
+    if (! isPrepared)
+        return 5;
+    
+    // take up a new position, then wait for the audio thread to discard the old samples
+    if (positionChange.compareAndSetBool (positionTaken, positionRequested))
+    {
+        nextReadPos = requestedPosition.get();
+        soundTouchProcessor.clear();
+        return 1;
+    }
+    
+    if (positionChange.get() != positionUnchanged)
+        return 1;
+    
+    bool didSomething = false;
+    
+    while (fifo.getNumReady() < lookahead)
+    {
+        if (soundTouchProcessor.getNumReady() <= 0)
+        {
+            readNextBufferChunk();
+            continue;
+        }
+        
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (jmin (soundTouchProcessor.getNumReady(), lookahead - fifo.getNumReady()),
+                             start1, size1, start2, size2);
+        
+        if (size1 > 0)
+            soundTouchProcessor.readSamples (fifoBuffer.getArrayOfChannels(), fifoBuffer.getNumChannels(), size1, start1);
+        
+        if (size2 > 0)
+            soundTouchProcessor.readSamples (fifoBuffer.getArrayOfChannels(), fifoBuffer.getNumChannels(), size2, start2);
+        
+        fifo.finishedWrite (size1 + size2);
+        didSomething = true;
+    }
+    
+    return didSomething ? 0 : getIdleTimeMs();
+}
+
+void SoundTouchAudioSource::readFromFifo (const AudioSourceChannelInfo& info)
+{
+    const int change = positionChange.get();
+    
+    if (change != positionUnchanged)
+    {
+        // anything rendered ahead is from the old position - it's discarded once the
+        // background thread has taken up the new one (and so stopped writing)
+        if (change == positionTaken)
+        {
+            fifo.finishedRead (fifo.getNumReady());
+            positionChange.compareAndSetBool (positionUnchanged, positionTaken);
+        }
+        
+        info.buffer->clear (info.startSample, info.numSamples);
+        return;
+    }
+    
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (info.numSamples, start1, size1, start2, size2);
+    
+    const int numChannels = jmin (fifoBuffer.getNumChannels(), info.buffer->getNumChannels());
+    
+    for (int i = 0; i < numChannels; ++i)
+    {
+        if (size1 > 0)
+            info.buffer->copyFrom (i, info.startSample, fifoBuffer, i, start1, size1);
+        
+        if (size2 > 0)
+            info.buffer->copyFrom (i, info.startSample + size1, fifoBuffer, i, start2, size2);
+    }
+    
+    fifo.finishedRead (size1 + size2);
+    
+    if (size1 + size2 < info.numSamples)
+    {
+        info.buffer->clear (info.startSample + size1 + size2, info.numSamples - (size1 + size2));
+        ++numUnderruns;
+    }
+    
+    const int samplesAhead = fifo.getNumReady();
+    if (samplesAhead < minimumSamplesAhead.get())
+        minimumSamplesAhead = samplesAhead;
+    
+    effectiveNextPlayPos += (int64) (info.numSamples * soundTouchProcessor.getEffectivePlaybackRatio());
+}
+
 
 #endif
@@ -39,8 +39,14 @@
 //==============================================================================
 /** An audio source that can independently change the rate, tempo and pitch of
     an audio source. This uses the SoundTouch library to perform the processing.
+ 
+    By default the processing is done in getNextAudioBlock(), on the calling
+    thread. To move it off the audio thread, call setBackgroundThread() so that
+    the output is rendered ahead of time into a FIFO, which the audio thread then
+    only has to copy from.
  */
-class SoundTouchAudioSource :   public PositionableAudioSource
+class SoundTouchAudioSource :   public PositionableAudioSource,
+                                public TimeSliceClient
 {
 public:
     //==============================================================================
@@ -75,6 +81,33 @@ public:
      */
     inline SoundTouchProcessor& getSoundTouchProcessor()        {   return soundTouchProcessor; }
     
+    //==============================================================================
+    /** Moves the time-stretching onto a background thread.
+        The stretched output is rendered up to lookaheadSamples ahead of playback,
+        so getNextAudioBlock() only copies samples out of a FIFO, without locking.
+        Position changes are handed over to the background thread, with silence
+        played until it has rendered from the new position. Note that changes
+        to the playback settings will be heard after the lookahead has played out.
+        Pass nullptr to go back to processing on the calling thread.
+     */
+    void setBackgroundThread (TimeSliceThread* thread, int lookaheadSamples = 8192);
+    
+    /** Returns the number of blocks that the background thread failed to render in time.
+     */
+    int getNumUnderruns() const                                 {   return numUnderruns.get();  }
+    
+    /** Returns the number of samples currently rendered ahead by the background thread.
+     */
+    int getNumSamplesAhead() const                              {   return fifo.getNumReady();  }
+    
+    /** Returns how full the lookahead currently is, from 0 to 1.
+     */
+    float getLookaheadFillLevel() const;
+    
+    /** Returns the lowest lookahead fill level seen since the last call to this method.
+     */
+    float getAndResetMinimumFillLevel();
+    
     //==============================================================================
     /** @internal. */
     void prepareToPlay (int samplesPerBlockExpected, double sampleRate);
@@ -101,6 +134,10 @@ public:
     /** Implements the PositionableAudioSource method. */
     void setLooping (bool shouldLoop)           { source->setLooping (shouldLoop);  }
     
+    //==============================================================================
+    /** @internal. */
+    int useTimeSlice();
+    
 private:
     //==============================================================================
     OptionalScopedPointer<PositionableAudioSource> source;
@@ -113,7 +150,21 @@ private:
     
     SoundTouchProcessor soundTouchProcessor;
     
+    TimeSliceThread* backgroundThread;
+    AbstractFifo fifo;
+    AudioSampleBuffer fifoBuffer;
+    int lookahead;
+    Atomic<int> numUnderruns, minimumSamplesAhead;
+    
+    // A position change in the background mode: requested (by setNextReadPosition), then
+    // taken up by the background thread, which waits for the old samples to be discarded
+    enum { positionUnchanged, positionRequested, positionTaken };
+    Atomic<int> positionChange;
+    Atomic<int64> requestedPosition;
+    
     void readNextBufferChunk();
+    void readFromFifo (const AudioSourceChannelInfo& info);
+    int getIdleTimeMs() const;
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SoundTouchAudioSource);
@@ -111,6 +111,19 @@ public:
 	
 	void performFFT (float* samples);
 	
+	/** Performs an inverse FFT of the contents of the FFT buffer, writing fftSize
+		samples. The buffer may be modified in place between the two (e.g. for fast
+		convolution), and is left undefined afterwards. An inverse FFT straight after
+		a forward one returns the original samples.
+	 */
+	void performInverseFFT (float* samples);
+	
+	/** Returns the gain of the forward FFT relative to the textbook DFT, which
+		depends on the platform (e.g. vDSP's results are twice the size).
+		The DC and Nyquist bins are always packed into realp[0] and imagp[0].
+	 */
+	float getForwardScale() const;
+	
 private:
     //==============================================================================
 	FFTProperties fftProperties;
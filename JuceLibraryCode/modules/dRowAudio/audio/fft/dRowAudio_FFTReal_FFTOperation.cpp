@@ -67,6 +67,17 @@ void FFTOperation::performFFT (float* samples)
     fftConfig->do_fft (fftBuffer.getData(), samples);
 }
 
+void FFTOperation::performInverseFFT (float* samples)
+{
+    fftConfig->do_ifft (fftBuffer.getData(), samples);
+    fftConfig->rescale (samples);
+}
+
+float FFTOperation::getForwardScale() const
+{
+    return 1.0f;
+}
+
 
 
 #endif //DROWAUDIO_USE_FFTREAL
\ No newline at end of file
@@ -69,6 +69,21 @@ void FFTOperation::performFFT (float* samples)
 	vDSP_fft_zrip (fftConfig, &fftBufferSplit, 1, fftProperties.fftSizeLog2, FFT_FORWARD);
 }
 
+void FFTOperation::performInverseFFT (float* samples)
+{
+	vDSP_fft_zrip (fftConfig, &fftBufferSplit, 1, fftProperties.fftSizeLog2, FFT_INVERSE);
+	vDSP_ztoc (&fftBufferSplit, 1, (COMPLEX *) samples, 2, fftProperties.fftSizeHalved);
+	
+	// a forward and inverse vDSP FFT scale by 2 * fftSize
+	const float scale = 0.5f / fftProperties.fftSize;
+	vDSP_vsmul (samples, 1, &scale, samples, 1, fftProperties.fftSize);
+}
+
+float FFTOperation::getForwardScale() const
+{
+	return 2.0f;
+}
+
 //============================================================================
 
 
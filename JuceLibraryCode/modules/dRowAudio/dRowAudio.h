@@ -403,6 +403,10 @@ using juce::UnitTest;
     #include "maths/dRowAudio_MathsUtilities.h"
 #endif
 
+#ifndef __DROWAUDIO_FASTMATH_H__
+    #include "maths/dRowAudio_FastMath.h"
+#endif
+
 #ifndef __DROWAUDIO_CUMULATIVEMOVINGAVERAGE_H__
     #include "maths/dRowAudio_CumulativeMovingAverage.h"
 #endif 
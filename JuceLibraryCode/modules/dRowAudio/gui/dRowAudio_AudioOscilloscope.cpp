@@ -32,20 +32,21 @@
 
 
 AudioOscilloscope::AudioOscilloscope()
-    : verticalZoomFactor (1.0f),
+    : fifo (fifoSize),
+      verticalZoomFactor (1.0f),
       horizontalZoomFactor (1.0f),
       backgroundColour(Colours::black),
       traceColour(Colours::green)
 {
-    lastBufferPos = bufferPos = 0;
-    bufferSize = 2048;		// Needs to be a power of 2 and larger than the width of your scope!
-    bufferSizeMask = bufferSize - 1;
-    circularBufferMax.calloc(bufferSize);
-    circularBufferMin.calloc(bufferSize);
-    clear();
-    currentMin = bufferLastMin = 1.0e6f;
-    currentMax = bufferLastMax = -currentMin;
-    numSamplesIn = 0;
+    fifoBuffer.calloc (fifoSize);
+    
+    for (int level = 0; level < numLevels; ++level)
+    {
+        levelMax[level].calloc (levelSize);
+        levelMin[level].calloc (levelSize);
+    }
+    
+    resetLevels();
     
     setOpaque (true);
     resized();                  // initialise image
@@ -55,8 +56,6 @@ AudioOscilloscope::AudioOscilloscope()
 AudioOscilloscope::~AudioOscilloscope()
 {
     stopTimer();
-    bufferSize = 0;
-    bufferSizeMask = 0;
 }
 
 //==============================================================================
@@ -65,15 +64,20 @@ void AudioOscilloscope::processBlock (const float* inputChannelData,
 {
     if (inputChannelData != 0)
     {
-        for (int i = 0; i < numSamples; ++i)
-            addSample (inputChannelData [i]);
+        // if the display has fallen behind, the rest of the block is dropped
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+        
+        FloatVectorOperations::copy (fifoBuffer + start1, inputChannelData, size1);
+        FloatVectorOperations::copy (fifoBuffer + start2, inputChannelData + size1, size2);
+        
+        fifo.finishedWrite (size1 + size2);
     }
 }
 
 void AudioOscilloscope::clear()
 {
-    zeromem (circularBufferMax, sizeof (float) * bufferSize);
-    zeromem (circularBufferMin, sizeof (float) * bufferSize);
+    clearRequested.set (1);
 }
 
 //==============================================================================
@@ -96,13 +100,36 @@ void AudioOscilloscope::paint (Graphics& g)
 
 void AudioOscilloscope::timerCallback()
 {
-    if(!bufferSize)
-        return;
+    if (clearRequested.exchange (0) != 0)
+        resetLevels();
+    
+    readFifo();
     
     const int width = getWidth();
     const float halfHeight = getHeight() * 0.5f;
-
-    const int numPixelsToDraw = bufferPos - lastBufferPos;
+    
+    // draw from the highest level with no more than one entry per pixel
+    const int samplesPerPixel = 1 + (int) (127.0 * horizontalZoomFactor);
+    int level = 0;
+    
+    while (level < numLevels - 1 && (2 << level) <= samplesPerPixel)
+        ++level;
+    
+    // skip anything that would scroll straight off the display (or has already left the pyramid)
+    numSamplesDrawn = jmax (numSamplesDrawn,
+                            numSamplesIn - width * (int64) samplesPerPixel,
+                            (numBuilt[level] - (levelSize - 4)) * ((int64) 1 << level));
+    
+    // a pixel can be drawn once all the entries that cover it are complete
+    int numPixelsToDraw = 0;
+    
+    while (numPixelsToDraw < width
+           && ((numSamplesDrawn + (numPixelsToDraw + 1) * (int64) samplesPerPixel - 1) >> level) < numBuilt[level])
+        ++numPixelsToDraw;
+    
+    if (numPixelsToDraw == 0)
+        return;
+    
     const int newSectionStart = width - numPixelsToDraw;
 
     // shuffle image along
@@ -117,15 +144,25 @@ void AudioOscilloscope::timerCallback()
     g.fillRect (newSectionStart, 0, numPixelsToDraw, waveformImage.getHeight());
     g.setColour (traceColour);
     
-    const int bp = bufferPos + bufferSize;
+    const float* const maxima = levelMax[level];
+    const float* const minima = levelMin[level];
     
-    for (int x = width; --x >= newSectionStart;)
+    for (int x = newSectionStart; x < width; ++x)
     {
-        const int samplesAgo = width - x;
+        // (at most three entries, at any zoom)
+        const int64 first = numSamplesDrawn >> level;
+        const int64 last = (numSamplesDrawn + samplesPerPixel - 1) >> level;
         
-        float max = circularBufferMax [(bp - samplesAgo) &bufferSizeMask];
-        float min = circularBufferMin [(bp - samplesAgo) &bufferSizeMask];
+        float max = maxima [first & (levelSize - 1)];
+        float min = minima [first & (levelSize - 1)];
         
+        for (int64 i = first + 1; i <= last; ++i)
+        {
+            max = jmax (max, maxima [i & (levelSize - 1)]);
+            min = jmin (min, minima [i & (levelSize - 1)]);
+        }
+        
+        // join up with the previous pixel
         if (min > bufferLastMax)
             min = bufferLastMax;
         if (max < bufferLastMin)
@@ -136,35 +173,76 @@ void AudioOscilloscope::timerCallback()
         
         g.drawLine ((float) x, halfHeight + (halfHeight * verticalZoomFactor * max),
                     (float) x, halfHeight + (halfHeight * verticalZoomFactor * min));
+        
+        numSamplesDrawn += samplesPerPixel;
     }
-    
-    lastBufferPos = bufferPos;
 
     repaint();
 }
 
 void AudioOscilloscope::addSample (const float sample)
 {
-    if(!bufferSize)
-        return;
+    processBlock (&sample, 1);
+}
+
+//==============================================================================
+void AudioOscilloscope::resetLevels()
+{
+    for (int level = 0; level < numLevels; ++level)
+    {
+        zeromem (levelMax[level], sizeof (float) * levelSize);
+        zeromem (levelMin[level], sizeof (float) * levelSize);
+        numBuilt[level] = 0;
+    }
     
-    if (sample > currentMax)
-        currentMax = sample;
-    if (sample < currentMin)
-        currentMin = sample;
+    numSamplesIn = numSamplesDrawn = 0;
+    bufferLastMin = 1.0e6f;
+    bufferLastMax = -bufferLastMin;
+}
+
+void AudioOscilloscope::readFifo()
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
     
-    const int samplesToAverage = 1 + (int) (127.0 * horizontalZoomFactor);
+    addSamples (fifoBuffer + start1, size1);
+    addSamples (fifoBuffer + start2, size2);
     
-    if (++numSamplesIn > samplesToAverage)
+    fifo.finishedRead (size1 + size2);
+}
+
+void AudioOscilloscope::addSamples (const float* samples, int numSamples)
+{
+    while (numSamples > 0)
     {
-        bufferPos = bufferPos & bufferSizeMask;
-        circularBufferMax [bufferPos] = currentMax;
-        circularBufferMin [bufferPos] = currentMin;
-        bufferPos++;
+        // add a few at a time, so that the levels above are built before any samples are overwritten
+        const int numToAdd = jmin (numSamples, (int) levelSize / 2);
         
-        numSamplesIn = 0;
-        currentMin = 1.0e6f;
-        currentMax = -currentMin;
+        for (int i = 0; i < numToAdd; ++i)
+        {
+            const int index = (int) (numSamplesIn++ & (levelSize - 1));
+            levelMax[0][index] = levelMin[0][index] = samples[i];
+        }
+        
+        numBuilt[0] = numSamplesIn;
+        
+        // each entry holds the peaks of two entries from the level below
+        for (int level = 1; level < numLevels; ++level)
+        {
+            const float* const belowMax = levelMax[level - 1];
+            const float* const belowMin = levelMin[level - 1];
+            
+            for (; numBuilt[level] < (numSamplesIn >> level); ++numBuilt[level])
+            {
+                const int index = (int) (numBuilt[level] & (levelSize - 1));
+                const int first = (int) ((numBuilt[level] * 2) & (levelSize - 1));
+                
+                levelMax[level][index] = jmax (belowMax[first], belowMax[first + 1]);
+                levelMin[level][index] = jmin (belowMin[first], belowMin[first + 1]);
+            }
+        }
+        
+        samples += numToAdd;
+        numSamples -= numToAdd;
     }
 }
-
@@ -39,6 +39,12 @@
     slightly more CPU intensive.
 	Use this when you need detailed images of a waveform instead of a general
     idea of what is passing through it.
+ 
+    The audio thread only copies each block into a FIFO. The message thread
+    then builds a pyramid of peaks from it, where each level holds the minimum
+    and maximum of pairs from the level below, and draws each pixel from the
+    level closest to the current zoom. Drawing therefore costs the same at any
+    zoom, and zoom changes apply to the history that has already arrived.
  */
 class AudioOscilloscope  :	public Component,
 							public Timer
@@ -64,7 +70,7 @@ public:
 	
 	/**	Clears the internal buffers.
         It is a good idea to call this when an audio device is started or stopped
-        to avoid clicks on the scope.
+        to avoid clicks on the scope. This can be called from any thread.
 	 */
 	void clear();
 	
@@ -102,11 +108,26 @@ public:
 	
 private:
     //==============================================================================
-    HeapBlock<float> circularBufferMax, circularBufferMin;
-	int bufferSizeMask;
-    float currentMax, currentMin;
-    int volatile bufferPos, lastBufferPos, bufferSize, numSamplesIn;
+    enum
+    {
+        numLevels = 8,          // level n holds the peaks of 2^n samples (for up to 128 samples per pixel)
+        levelSize = 4096,       // entries kept at each level (needs to be a power of 2)
+        fifoSize = 32768        // samples waiting for the message thread
+    };
+    
+    AbstractFifo fifo;
+    HeapBlock<float> fifoBuffer;
+    Atomic<int> clearRequested;
+    
+    // (message thread only)
+    HeapBlock<float> levelMax[numLevels], levelMin[numLevels];
+    int64 numBuilt[numLevels];
+    int64 numSamplesIn, numSamplesDrawn;
 	float bufferLastMax, bufferLastMin;
+    
+    void resetLevels();
+    void readFifo();
+    void addSamples (const float* samples, int numSamples);
 	
     Image waveformImage;
     
@@ -53,7 +53,7 @@ SegmentedMeter::~SegmentedMeter()
 
 void SegmentedMeter::calculateSegments()
 {
-	float numDecibels = (float) toDecibels (level.getCurrent());
+	float numDecibels = FastMath::gainToDecibels ((float) level.getCurrent());
 	// map decibels to numSegs
 	numSegs = jmax (0, roundToInt ((numDecibels / decibelsPerSeg) + (totalNumSegs - numRedSeg)));
 	
@@ -136,15 +136,15 @@ void Sonogram::renderScopeLine()
     const float yScale = (float) h / (numBins + 1);
     const float* data = fftEngine.getMagnitudesBuffer().getData();
     
-    float amp = jlimit (0.0f, 1.0f, (float) (1 + (toDecibels (data[0]) / 100.0f)));
+    float amp = jlimit (0.0f, 1.0f, (float) (1 + (FastMath::gainToDecibels (data[0]) / 100.0f)));
     float y2, y1 = 0;
     
     if (logFrequency)
     {
         for (int i = 0; i < numBins; ++i)
         {
-            amp = jlimit (0.0f, 1.0f, (float) (1 + (toDecibels (data[i]) / 100.0f)));
-            y2 = log10 (1 + 39 * ((i + 1.0f) / numBins)) / log10 (40.0f) * h;
+            amp = jlimit (0.0f, 1.0f, (float) (1 + (FastMath::gainToDecibels (data[i]) / 100.0f)));
+            y2 = FastMath::log2 (1 + 39 * ((i + 1.0f) / numBins)) / FastMath::log2 (40.0f) * h;
 
             g.setColour (Colour::greyLevel (amp));
             g.fillRect ((float)x, h - y2, scopeLineW, y1 - y2);
@@ -156,7 +156,7 @@ void Sonogram::renderScopeLine()
     {
         for (int i = 0; i < numBins; ++i)
         {
-            amp = jlimit (0.0f, 1.0f, (float) (1 + (toDecibels (data[i]) / 100.0f)));
+            amp = jlimit (0.0f, 1.0f, (float) (1 + (FastMath::gainToDecibels (data[i]) / 100.0f)));
             y2 = (i + 1) * yScale;
             
             g.setColour (Colour::greyLevel (amp));
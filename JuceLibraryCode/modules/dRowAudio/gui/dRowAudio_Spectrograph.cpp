@@ -126,15 +126,15 @@ Image Spectrograph::createImage() const
         const float yScale = (float) h / (numBins + 1);
         const float* data = fftMagnitudesBlocks.getUnchecked (i);
         
-        float amp = jlimit (0.0f, 1.0f, (float) (1 + (toDecibels (data[0]) / 100.0f)));
+        float amp = jlimit (0.0f, 1.0f, (float) (1 + (FastMath::gainToDecibels (data[0]) / 100.0f)));
         float y2, y1 = 0.0f;
         
         if (logFrequency)
         {
             for (int i = 0; i < numBins; ++i)
             {
-                amp = jlimit (0.0f, 1.0f, (float) (1 + (toDecibels (data[i]) / 100.0f)));
-                y2 = log10 (1 + 39 * ((i + 1.0f) / numBins)) / log10 (40.0f) * h;
+                amp = jlimit (0.0f, 1.0f, (float) (1 + (FastMath::gainToDecibels (data[i]) / 100.0f)));
+                y2 = FastMath::log2 (1 + 39 * ((i + 1.0f) / numBins)) / FastMath::log2 (40.0f) * h;
                 
                 g.setColour (Colour::greyLevel (amp));
                 g.fillRect (x1, h - y2, bW, y1 - y2);
@@ -146,7 +146,7 @@ Image Spectrograph::createImage() const
         {
             for (int i = 0; i < numBins; ++i)
             {
-                amp = jlimit (0.0f, 1.0f, (float) (1 + (toDecibels (data[i]) / 100.0f)));
+                amp = jlimit (0.0f, 1.0f, (float) (1 + (FastMath::gainToDecibels (data[i]) / 100.0f)));
                 y2 = (i + 1) * yScale;
                 
                 g.setColour (Colour::greyLevel (amp));
@@ -132,15 +132,15 @@ void Spectroscope::renderScopeImage()
         const float xScale = (float)w / (numBins + 1);
         const float* data = fftEngine.getMagnitudesBuffer().getData();
         
-        float y2, y1 = jlimit (0.0f, 1.0f, float (1 + (toDecibels (data[0]) / 100.0f)));
+        float y2, y1 = jlimit (0.0f, 1.0f, float (1 + (FastMath::gainToDecibels (data[0]) / 100.0f)));
         float x2, x1 = 0;
         
         if (logFrequency)
 		{
 			for (int i = 0; i < numBins; ++i)
 			{
-				y2 = jlimit (0.0f, 1.0f, float (1 + (toDecibels (data[i]) / 100.0f)));
-				x2 = log10 (1 + 39 * ((i + 1.0f) / numBins)) / log10 (40.0f) * w;
+				y2 = jlimit (0.0f, 1.0f, float (1 + (FastMath::gainToDecibels (data[i]) / 100.0f)));
+				x2 = FastMath::log2 (1 + 39 * ((i + 1.0f) / numBins)) / FastMath::log2 (40.0f) * w;
                 
 				g.drawLine (x1, h - h * y1,
 						    x2, h - h * y2);
@@ -153,7 +153,7 @@ void Spectroscope::renderScopeImage()
 		{
 			for (int i = 0; i < numBins; ++i)
 			{
-				y2 = jlimit (0.0f, 1.0f, float (1 + (toDecibels (data[i]) / 100.0f)));
+				y2 = jlimit (0.0f, 1.0f, float (1 + (FastMath::gainToDecibels (data[i]) / 100.0f)));
 				x2 = (i + 1) * xScale;
 				
 				g.drawLine (x1, h - h * y1,
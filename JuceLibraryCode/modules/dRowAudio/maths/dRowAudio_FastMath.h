@@ -0,0 +1,316 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef __DROWAUDIO_FASTMATH_H__
+#define __DROWAUDIO_FASTMATH_H__
+
+#if JUCE_MSVC
+    #pragma warning (disable: 4505)
+#endif
+
+#if defined (__clang__)
+ #if __has_feature (cxx_constexpr)
+  #define DROWAUDIO_CONSTEXPR constexpr
+ #endif
+#elif defined (__GXX_EXPERIMENTAL_CXX0X__) && (__GNUC__ * 100 + __GNUC_MINOR__) >= 406
+ #define DROWAUDIO_CONSTEXPR constexpr
+#endif
+
+#ifndef DROWAUDIO_CONSTEXPR
+ #define DROWAUDIO_CONSTEXPR
+#endif
+
+//==============================================================================
+/** Fast approximations of the maths functions used for pitch, filter and level
+    conversions, for when they need calling per block, per note or per sample.
+
+    All of these are branch-free, so loops calling them can be vectorised by the
+    compiler, and the array versions are written so that they will be. The error
+    bounds given are the largest seen over the stated ranges, compared with the
+    double precision library functions.
+
+    These expect finite inputs in the ranges given, and don't handle NaNs, infinities
+    or denormals as the library functions do.
+ */
+namespace FastMath
+{
+    //==============================================================================
+    /** @internal */
+    union FloatBits
+    {
+        float f;
+        int32 i;
+    };
+
+    //==============================================================================
+    /** Returns 2 to the power of x.
+        Relative error < 2.5e-7 for x in [-126, 126] (results are clamped outside this).
+     */
+    inline float exp2 (float x) noexcept
+    {
+        x = jlimit (-126.0f, 126.0f, x);
+
+        // split into an integer power and a fraction in [-0.5, 0.5]
+        const int32 n = (int32) (x + 126.5f) - 126;
+        const float f = (x - (float) n) * 0.693147181f;
+
+        // e^f, with the Taylor series to 6th order
+        const float p = 1.0f + f * (1.0f + f * (0.5f + f * (0.166666667f + f * (0.0416666667f
+                                  + f * (0.00833333333f + f * 0.00138888889f)))));
+
+        FloatBits scale;
+        scale.i = (n + 127) << 23;
+        return p * scale.f;
+    }
+
+    /** Returns the base-2 logarithm of x.
+        Error < 1.5e-7 relative to max (1, |log2 (x)|), for any normal, positive x.
+     */
+    inline float log2 (float x) noexcept
+    {
+        FloatBits bits;
+        bits.f = x;
+
+        // split into an exponent and a mantissa in [sqrt(0.5), sqrt(2))
+        int32 e = ((bits.i >> 23) & 0xff) - 127;
+        bits.i = (bits.i & 0x007fffff) | 0x3f800000;
+
+        const int32 above = bits.f > 1.41421356f;
+        e += above;
+        bits.f *= 1.0f - 0.5f * (float) above;
+
+        // log2(m) = 2 atanh(s) / ln(2), with s = (m - 1) / (m + 1), |s| < 0.172
+        const float s = (bits.f - 1.0f) / (bits.f + 1.0f);
+        const float s2 = s * s;
+
+        return (float) e + s * (2.88539008f + s2 * (0.961796694f + s2 * (0.577078016f + s2 * 0.412198583f)));
+    }
+
+    /** Returns e to the power of x.
+        Relative error < 2.5e-7 + 5e-8 |x|, for x in [-87, 87].
+     */
+    inline float exp (float x) noexcept             { return exp2 (x * 1.44269504f); }
+
+    /** Returns the natural logarithm of x.
+        Error < 1.5e-7 relative to max (1, |log (x)|), for any normal, positive x.
+     */
+    inline float log (float x) noexcept             { return log2 (x) * 0.693147181f; }
+
+    /** Returns x to the power of y, for positive x (returning 0 for x <= 0).
+        Relative error < 1.5e-6 for x in [0.01, 100] and y in [-4, 4] (in general, about
+        2.5e-7 + 1e-7 |y log2 (x)|, where the result is between 1e-38 and 1e38).
+     */
+    inline float pow (float x, float y) noexcept
+    {
+        return exp2 (y * log2 (jmax (x, 1.17549435e-38f))) * (float) (x > 0.0f);
+    }
+
+    //==============================================================================
+    /** @internal - wraps x (|x| < 1e5) to [-pi, pi], in two parts to keep the precision of 2pi. */
+    inline float wrapToPi (float x) noexcept
+    {
+        const float k = (float) ((int32) (x * 0.159154943f + 16384.5f) - 16384);
+        return (x - k * 6.28125f) - k * 0.00193530717f;
+    }
+
+    /** @internal - the sine of x in [-pi/2, pi/2], from the Taylor series to the 11th order. */
+    inline float sinOfQuadrant (float x) noexcept
+    {
+        const float x2 = x * x;
+        return x * (1.0f + x2 * (-0.166666667f + x2 * (0.00833333333f + x2 * (-0.000198412698f
+                             + x2 * (2.75573192e-6f + x2 * -2.50521084e-8f)))));
+    }
+
+    /** Returns the sine of x.
+        Absolute error < 2.5e-7 for x in [-100, 100] (and |x| must be less than 1e5).
+     */
+    inline float sin (float x) noexcept
+    {
+        x = wrapToPi (x);
+
+        // reflect into [-pi/2, pi/2], where sin (pi - x) = sin (x)
+        const float sign = x < 0.0f ? -1.0f : 1.0f;
+        const float a = x * sign;
+        return sinOfQuadrant (sign * (a > 1.57079633f ? 3.14159265f - a : a));
+    }
+
+    /** Returns the cosine of x.
+        Absolute error < 2.5e-7 for x in [-100, 100] (and |x| must be less than 1e5).
+     */
+    inline float cos (float x) noexcept
+    {
+        // cos (x) = cos (|x|) = sin (pi/2 - |x|), once x is wrapped (adding pi/2 before
+        // wrapping would lose the precision of a large x)
+        const float a = std::abs (wrapToPi (x));
+        return sinOfQuadrant ((1.5703125f - a) + 4.83826795e-4f); // (pi/2 in two parts, for precision)
+    }
+
+    /** Returns the tangent of x, for x in (-pi/2, pi/2).
+        Relative error < 2.5e-7 for |x| < pi/2 - 1e-4 (e.g. as the pre-warped frequency of a
+        bilinear transform, up to 0.49996 of the sample rate).
+     */
+    inline float tan (float x) noexcept
+    {
+        const float sign = x < 0.0f ? -1.0f : 1.0f;
+        float a = x * sign;
+
+        // tan (x) = 1 / tan (pi/2 - x), so we only need to approximate up to pi/4
+        const bool invert = a > 0.785398163f;
+        a = invert ? (1.5703125f - a) + 4.83826795e-4f : a; // (pi/2 in two parts, for precision near the pole)
+
+        // Lambert's continued fraction, to 7 terms
+        const float a2 = a * a;
+        const float num = a * (135135.0f + a2 * (-17325.0f + a2 * (378.0f - a2)));
+        const float den = 135135.0f + a2 * (-62370.0f + a2 * (3150.0f - 28.0f * a2));
+
+        return sign * (invert ? den / num : num / den);
+    }
+
+    //==============================================================================
+    /** Converts a gain to decibels, returning minusInfinityDb for gains at or below
+        the gain of minusInfinityDb.
+        Absolute error < 2e-5 dB for gains in [1e-5, 1e5].
+     */
+    inline float gainToDecibels (float gain, float minusInfinityDb = -100.0f) noexcept
+    {
+        return jmax (minusInfinityDb, 6.02059991f * log2 (jmax (gain, 1.17549435e-38f)));
+    }
+
+    /** Converts decibels to a gain, returning 0 for anything at or below minusInfinityDb.
+        Relative error < 1.5e-6 for decibels in [-100, 100].
+     */
+    inline float decibelsToGain (float decibels, float minusInfinityDb = -100.0f) noexcept
+    {
+        return exp2 (decibels * 0.166096405f) * (float) (decibels > minusInfinityDb);
+    }
+
+    //==============================================================================
+    /** Returns the frequency in Hz of a (possibly fractional) MIDI note number, where
+        note 69 is the given frequency of A.
+        Relative error < 6e-7 for notes 0 to 127.
+     */
+    inline float noteToHertz (float noteNumber, float frequencyOfA = 440.0f) noexcept
+    {
+        return frequencyOfA * exp2 ((noteNumber - 69.0f) * 0.0833333333f);
+    }
+
+    /** Returns the MIDI note number (possibly fractional) of a frequency in Hz. */
+    inline float hertzToNote (float frequency, float frequencyOfA = 440.0f) noexcept
+    {
+        return 69.0f + 12.0f * log2 (frequency / frequencyOfA);
+    }
+
+    /** @internal - the ratios of the 12 semitones in an octave to its root. */
+    inline DROWAUDIO_CONSTEXPR double semitoneRatio (int semitone) noexcept
+    {
+        return semitone == 0  ? 1.0                : semitone == 1  ? 1.0594630943592953
+             : semitone == 2  ? 1.122462048309373  : semitone == 3  ? 1.189207115002721
+             : semitone == 4  ? 1.2599210498948732 : semitone == 5  ? 1.3348398541700344
+             : semitone == 6  ? 1.4142135623730951 : semitone == 7  ? 1.4983070768766815
+             : semitone == 8  ? 1.5874010519681994 : semitone == 9  ? 1.681792830507429
+             : semitone == 10 ? 1.7817974362806785 : 1.8877486253633868;
+    }
+
+    /** Returns the frequency in Hz of MIDI note (0 to 127), in equal temperament with
+        A = 440Hz. This can be evaluated at compile time, e.g. for building tables.
+     */
+    inline DROWAUDIO_CONSTEXPR double midiNoteToHertzExact (int noteNumber) noexcept
+    {
+        // note 0 is C-1, at 440 * 2^(-69/12) = 8.1757989...Hz
+        return 8.175798915643707 * (double) (1 << (noteNumber / 12)) * semitoneRatio (noteNumber % 12);
+    }
+
+    /** Returns the frequency in Hz of a MIDI note (0 to 127) from a table, with A = 440Hz. */
+    inline float midiNoteToHertz (int noteNumber) noexcept
+    {
+        static const float frequencies[128] =
+        {
+            8.17579892f, 8.66195722f, 9.177024f, 9.72271824f, 10.3008612f, 10.9133822f, 11.5623257f, 12.2498574f,
+            12.9782718f, 13.75f, 14.5676175f, 15.4338532f, 16.3515978f, 17.3239144f, 18.354048f, 19.4454365f,
+            20.6017223f, 21.8267645f, 23.1246514f, 24.4997147f, 25.9565436f, 27.5f, 29.1352351f, 30.8677063f,
+            32.7031957f, 34.6478289f, 36.708096f, 38.890873f, 41.2034446f, 43.6535289f, 46.2493028f, 48.9994295f,
+            51.9130872f, 55.0f, 58.2704702f, 61.7354127f, 65.4063913f, 69.2956577f, 73.416192f, 77.7817459f,
+            82.4068892f, 87.3070579f, 92.4986057f, 97.998859f, 103.826174f, 110.0f, 116.54094f, 123.470825f,
+            130.812783f, 138.591315f, 146.832384f, 155.563492f, 164.813778f, 174.614116f, 184.997211f, 195.997718f,
+            207.652349f, 220.0f, 233.081881f, 246.941651f, 261.625565f, 277.182631f, 293.664768f, 311.126984f,
+            329.627557f, 349.228231f, 369.994423f, 391.995436f, 415.304698f, 440.0f, 466.163762f, 493.883301f,
+            523.251131f, 554.365262f, 587.329536f, 622.253967f, 659.255114f, 698.456463f, 739.988845f, 783.990872f,
+            830.609395f, 880.0f, 932.327523f, 987.766603f, 1046.50226f, 1108.73052f, 1174.65907f, 1244.50793f,
+            1318.51023f, 1396.91293f, 1479.97769f, 1567.98174f, 1661.21879f, 1760.0f, 1864.65505f, 1975.53321f,
+            2093.00452f, 2217.46105f, 2349.31814f, 2489.01587f, 2637.02046f, 2793.82585f, 2959.95538f, 3135.96349f,
+            3322.43758f, 3520.0f, 3729.31009f, 3951.06641f, 4186.00904f, 4434.9221f, 4698.63629f, 4978.03174f,
+            5274.04091f, 5587.6517f, 5919.91076f, 6271.92698f, 6644.87516f, 7040.0f, 7458.62018f, 7902.13282f,
+            8372.01809f, 8869.84419f, 9397.27257f, 9956.06348f, 10548.0818f, 11175.3034f, 11839.8215f, 12543.854f
+        };
+
+        return frequencies [noteNumber & 127];
+    }
+
+    //==============================================================================
+    /** Applies exp2() to an array of values (dest and source may be the same). */
+    inline void exp2 (float* dest, const float* source, int numValues) noexcept
+    {
+        for (int i = 0; i < numValues; ++i)
+            dest[i] = exp2 (source[i]);
+    }
+
+    /** Applies log2() to an array of values (dest and source may be the same). */
+    inline void log2 (float* dest, const float* source, int numValues) noexcept
+    {
+        for (int i = 0; i < numValues; ++i)
+            dest[i] = log2 (source[i]);
+    }
+
+    /** Applies sin() to an array of values (dest and source may be the same). */
+    inline void sin (float* dest, const float* source, int numValues) noexcept
+    {
+        for (int i = 0; i < numValues; ++i)
+            dest[i] = sin (source[i]);
+    }
+
+    /** Converts an array of gains to decibels (dest and source may be the same). */
+    inline void gainToDecibels (float* dest, const float* source, int numValues,
+                                float minusInfinityDb = -100.0f) noexcept
+    {
+        for (int i = 0; i < numValues; ++i)
+            dest[i] = gainToDecibels (source[i], minusInfinityDb);
+    }
+
+    /** Converts an array of decibel values to gains (dest and source may be the same). */
+    inline void decibelsToGain (float* dest, const float* source, int numValues,
+                                float minusInfinityDb = -100.0f) noexcept
+    {
+        for (int i = 0; i < numValues; ++i)
+            dest[i] = decibelsToGain (source[i], minusInfinityDb);
+    }
+}
+
+#endif  // __DROWAUDIO_FASTMATH_H__
@@ -124,6 +124,70 @@ public:
 
 static PitchTests pitchTests;
 
+//==============================================================================
+class FastMathTests  : public UnitTest
+{
+public:
+    FastMathTests() : UnitTest ("FastMath") {}
+    
+    void runTest()
+    {
+        beginTest ("exp2, log2 and pow");
+        
+        for (float x = -126.0f; x <= 126.0f; x += 0.01f)
+            expect (relativeError (FastMath::exp2 (x), std::pow (2.0, (double) x)) < 2.5e-7);
+        
+        for (float x = 1.0e-30f; x < 1.0e30f; x *= 1.01f)
+            expect (std::abs (FastMath::log2 (x) - std::log ((double) x) / std::log (2.0)) < 1.5e-7 * jmax (1.0, std::abs (std::log ((double) x) / std::log (2.0))));
+        
+        for (float x = 0.01f; x < 100.0f; x *= 1.01f)
+            for (float y = -4.0f; y <= 4.0f; y += 0.25f)
+                expect (relativeError (FastMath::pow (x, y), std::pow ((double) x, (double) y)) < 1.5e-6);
+        
+        expectEquals (FastMath::pow (0.0f, 2.0f), 0.0f);
+        
+        beginTest ("sin, cos and tan");
+        
+        for (float x = -100.0f; x <= 100.0f; x += 0.001f)
+        {
+            expect (std::abs (FastMath::sin (x) - std::sin ((double) x)) < 2.5e-7);
+            expect (std::abs (FastMath::cos (x) - std::cos ((double) x)) < 2.5e-7);
+        }
+        
+        for (float x = -float_Pi * 0.5f + 1.0e-4f; x < float_Pi * 0.5f - 1.0e-4f; x += 0.0001f)
+            expect (relativeError (FastMath::tan (x), std::tan ((double) x)) < 2.5e-7);
+        
+        beginTest ("Decibels and pitch");
+        
+        for (float gain = 1.0e-5f; gain < 1.0e5f; gain *= 1.01f)
+            expect (std::abs (FastMath::gainToDecibels (gain, -1000.0f) - 20.0 * std::log10 ((double) gain)) < 2.0e-5);
+        
+        for (float dB = -99.0f; dB <= 100.0f; dB += 0.01f)
+            expect (relativeError (FastMath::decibelsToGain (dB), std::pow (10.0, dB / 20.0)) < 1.5e-6);
+        
+        expectEquals (FastMath::gainToDecibels (0.0f), -100.0f);
+        expectEquals (FastMath::decibelsToGain (-100.0f), 0.0f);
+        
+        for (int note = 0; note < 128; ++note)
+        {
+            const double hertz = 440.0 * std::pow (2.0, (note - 69) / 12.0);
+            
+            expect (relativeError (FastMath::midiNoteToHertz (note), hertz) < 1.0e-7);
+            expect (relativeError (FastMath::midiNoteToHertzExact (note), hertz) < 1.0e-12);
+            expect (relativeError (FastMath::noteToHertz ((float) note), hertz) < 6.0e-7);
+        }
+        
+        expect (std::abs (FastMath::hertzToNote (440.0f) - 69.0f) < 1.0e-5f);
+    }
+    
+    static double relativeError (double value, double expected)
+    {
+        return std::abs (value - expected) / std::abs (expected);
+    }
+};
+
+static FastMathTests fastMathTests;
+
 //==============================================================================
 
 #endif // DROWAUDIO_UNIT_TESTS
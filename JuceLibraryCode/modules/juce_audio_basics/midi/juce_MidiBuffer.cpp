@@ -67,29 +67,66 @@ namespace MidiBufferHelpers
 
         return size;
     }
+
+    // Returns the end of the run of events (in time order) that starts at d.
+    static const uint8* findEndOfRun (const uint8* d, const uint8* const end) noexcept
+    {
+        for (;;)
+        {
+            const uint8* const next = d + getEventTotalSize (d);
+
+            if (next >= end || getEventTime (next) < getEventTime (d))
+                return next;
+
+            d = next;
+        }
+    }
+
+    // Merges two runs of events into dest, taking the first run's events first where times are equal.
+    static uint8* mergeRuns (const uint8* a, const uint8* const endA,
+                             const uint8* b, const uint8* const endB, uint8* dest) noexcept
+    {
+        while (a < endA && b < endB)
+        {
+            const uint8*& next = (getEventTime (b) < getEventTime (a)) ? b : a;
+            const int size = getEventTotalSize (next);
+            memcpy (dest, next, (size_t) size);
+            dest += size;
+            next += size;
+        }
+
+        memcpy (dest, a, (size_t) (endA - a));
+        dest += endA - a;
+        memcpy (dest, b, (size_t) (endB - b));
+        return dest + (endB - b);
+    }
 }
 
 //==============================================================================
 MidiBuffer::MidiBuffer() noexcept
-    : bytesUsed (0)
+    : bytesUsed (0), lastEventTime (0), needsSorting (false)
 {
 }
 
 MidiBuffer::MidiBuffer (const MidiMessage& message) noexcept
-    : bytesUsed (0)
+    : bytesUsed (0), lastEventTime (0), needsSorting (false)
 {
     addEvent (message, 0);
 }
 
 MidiBuffer::MidiBuffer (const MidiBuffer& other) noexcept
-    : data (other.data),
-      bytesUsed (other.bytesUsed)
+    : bytesUsed (0), lastEventTime (0), needsSorting (false)
 {
+    operator= (other);
 }
 
 MidiBuffer& MidiBuffer::operator= (const MidiBuffer& other) noexcept
 {
+    other.sortIfNeeded(); // (so that the copy doesn't need any sort space)
+
     bytesUsed = other.bytesUsed;
+    lastEventTime = other.lastEventTime;
+    needsSorting = false;
     data = other.data;
 
     return *this;
@@ -99,6 +136,9 @@ void MidiBuffer::swapWith (MidiBuffer& other) noexcept
 {
     data.swapWith (other.data);
     std::swap (bytesUsed, other.bytesUsed);
+    std::swap (lastEventTime, other.lastEventTime);
+    std::swap (needsSorting, other.needsSorting);
+    sortSpace.swapWith (other.sortSpace);
 }
 
 MidiBuffer::~MidiBuffer()
@@ -113,10 +153,13 @@ inline uint8* MidiBuffer::getData() const noexcept
 void MidiBuffer::clear() noexcept
 {
     bytesUsed = 0;
+    needsSorting = false;
 }
 
 void MidiBuffer::clear (const int startSample, const int numSamples)
 {
+    sortIfNeeded();
+
     uint8* const start = findEventAfter (getData(), startSample - 1);
     uint8* const end   = findEventAfter (start, startSample + numSamples - 1);
 
@@ -128,6 +171,21 @@ void MidiBuffer::clear (const int startSample, const int numSamples)
             memmove (start, end, (size_t) bytesToMove);
 
         bytesUsed -= (int) (end - start);
+
+        // if the last events were removed, the last one is now the one before them
+        if (bytesToMove <= 0 && bytesUsed > 0)
+        {
+            const uint8* d = getData();
+            const uint8* last = d;
+
+            while (d < start)
+            {
+                last = d;
+                d += MidiBufferHelpers::getEventTotalSize (d);
+            }
+
+            lastEventTime = MidiBufferHelpers::getEventTime (last);
+        }
     }
 }
 
@@ -145,11 +203,17 @@ void MidiBuffer::addEvent (const void* const newData, const int maxBytes, const
         size_t spaceNeeded = (size_t) bytesUsed + (size_t) numBytes + sizeof (int) + sizeof (uint16);
         data.ensureSize ((spaceNeeded + spaceNeeded / 2 + 8) & ~(size_t) 7);
 
-        uint8* d = findEventAfter (getData(), sampleNumber);
-        const int bytesToMove = bytesUsed - (int) (d - getData());
+        // Events are always appended - if this one's out of order, the buffer is sorted when it's next read
+        if (bytesUsed > 0 && sampleNumber < lastEventTime)
+            needsSorting = true;
+        else
+            lastEventTime = sampleNumber;
 
-        if (bytesToMove > 0)
-            memmove (d + numBytes + sizeof (int) + sizeof (uint16), d, (size_t) bytesToMove);
+        // ..and the space for sorting it grows here, so that reading it never allocates
+        if (needsSorting)
+            sortSpace.ensureSize (data.getSize());
+
+        uint8* d = getData() + bytesUsed;
 
         *reinterpret_cast <int*> (d) = sampleNumber;
         d += sizeof (int);
@@ -207,26 +271,54 @@ int MidiBuffer::getNumEvents() const noexcept
 
 int MidiBuffer::getFirstEventTime() const noexcept
 {
+    sortIfNeeded();
     return bytesUsed > 0 ? MidiBufferHelpers::getEventTime (data.getData()) : 0;
 }
 
 int MidiBuffer::getLastEventTime() const noexcept
 {
-    if (bytesUsed == 0)
-        return 0;
+    return bytesUsed > 0 ? lastEventTime : 0;
+}
 
-    const uint8* d = getData();
-    const uint8* const endData = d + bytesUsed;
+void MidiBuffer::sortIfNeeded() const
+{
+    if (! needsSorting)
+        return;
+
+    needsSorting = false;
+
+    // A natural merge sort: the buffer is a series of runs of events in time order (usually
+    // a long one, followed by the events that were added out of order), which are merged in
+    // pairs until there's only one. (addEvent() has made sortSpace big enough)
+    jassert (sortSpace.getSize() >= (size_t) bytesUsed);
+
+    const uint8* source = getData();
+    uint8* dest = static_cast <uint8*> (sortSpace.getData());
+    int numRuns;
 
-    for (;;)
+    do
     {
-        const uint8* const nextOne = d + MidiBufferHelpers::getEventTotalSize (d);
+        const uint8* const end = source + bytesUsed;
+        uint8* d = dest;
+        numRuns = 0;
 
-        if (nextOne >= endData)
-            return MidiBufferHelpers::getEventTime (d);
+        for (const uint8* run = source; run < end; ++numRuns)
+        {
+            const uint8* const middle = MidiBufferHelpers::findEndOfRun (run, end);
+            const uint8* const next = middle < end ? MidiBufferHelpers::findEndOfRun (middle, end) : end;
+
+            d = MidiBufferHelpers::mergeRuns (run, middle, middle, next, d);
+            run = next;
+        }
 
-        d = nextOne;
+        uint8* const merged = dest;
+        dest = const_cast <uint8*> (source);
+        source = merged;
     }
+    while (numRuns > 1);
+
+    if (source != getData())
+        memcpy (getData(), source, (size_t) bytesUsed);
 }
 
 uint8* MidiBuffer::findEventAfter (uint8* d, const int samplePosition) const noexcept
@@ -244,6 +336,7 @@ MidiBuffer::Iterator::Iterator (const MidiBuffer& buffer_) noexcept
     : buffer (buffer_),
       data (buffer_.getData())
 {
+    buffer.sortIfNeeded();
 }
 
 MidiBuffer::Iterator::~Iterator() noexcept
@@ -253,6 +346,7 @@ MidiBuffer::Iterator::~Iterator() noexcept
 //==============================================================================
 void MidiBuffer::Iterator::setNextSamplePosition (const int samplePosition) noexcept
 {
+    buffer.sortIfNeeded();
     data = buffer.getData();
     const uint8* dataEnd = data + buffer.bytesUsed;
 
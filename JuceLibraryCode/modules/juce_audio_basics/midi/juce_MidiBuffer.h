@@ -33,6 +33,13 @@
     Analogous to the AudioSampleBuffer, this holds a set of midi events with
     integer time-stamps. The buffer is kept sorted in order of the time-stamps.
 
+    Events added in time order are simply appended to the buffer, so filling it in
+    order is quick however many events there are. Events added out of order are
+    appended too, and the buffer is then sorted (keeping events with the same time
+    in the order they were added) the next time it's read. Because reading a buffer
+    may sort it, a buffer that's read by more than one thread at a time should be
+    sorted first (e.g. by creating an Iterator for it).
+
     If you're working with a sequence of midi events that may need to be manipulated
     or read/written to a midi file, then MidiMessageSequence is probably a more
     appropriate container. MidiBuffer is designed for lower-level streams of raw
@@ -88,7 +95,7 @@ public:
 
         The sample number will be used to determine the position of the event in
         the buffer, which is always kept sorted. The MidiMessage's timestamp is
-        ignored.
+        ignored. Adding events in time order is fastest (see the class description).
 
         If an event is added whose sample position is the same as one or more events
         already in the buffer, the new event will be placed after the existing ones.
@@ -198,7 +205,10 @@ public:
         bool getNextEvent (MidiMessage& result,
                            int& samplePosition) noexcept;
 
-        /** Retrieves the next event from the buffer.
+        /** Retrieves the next event from the buffer, without copying it.
+
+            This is quicker than getting a MidiMessage, which may need to allocate
+            memory for longer messages.
 
             @param midiData     on return, this pointer will be set to a block of data containing
                                 the midi message. Note that to make it fast, this is a pointer
@@ -227,9 +237,13 @@ private:
     friend class MidiBuffer::Iterator;
     MemoryBlock data;
     int bytesUsed;
+    int lastEventTime;              // the latest time of any event in the buffer
+    mutable bool needsSorting;      // true if events have been added out of order
+    mutable MemoryBlock sortSpace;  // grown by addEvent() when needsSorting is set, so sorting never allocates
 
     uint8* getData() const noexcept;
     uint8* findEventAfter (uint8*, int samplePosition) const noexcept;
+    void sortIfNeeded() const;
 
     JUCE_LEAK_DETECTOR (MidiBuffer)
 };
@@ -145,13 +145,16 @@ void MidiKeyboardState::processNextMidiBuffer (MidiBuffer& buffer,
                                                const bool injectIndirectEvents)
 {
     MidiBuffer::Iterator i (buffer);
-    MidiMessage message (0xf4, 0.0);
-    int time;
+    const uint8* data;
+    int size, time;
 
     const ScopedLock sl (lock);
 
-    while (i.getNextEvent (message, time))
-        processNextMidiEvent (message);
+    // (the events are read in place - only channel messages, which are small enough not to
+    // allocate any memory, are made into MidiMessages)
+    while (i.getNextEvent (data, size, time))
+        if (*data < 0xf0)
+            processNextMidiEvent (MidiMessage (data, size, time));
 
     if (injectIndirectEvents)
     {
@@ -159,10 +162,10 @@ void MidiKeyboardState::processNextMidiBuffer (MidiBuffer& buffer,
         const int firstEventToAdd = eventsToAdd.getFirstEventTime();
         const double scaleFactor = numSamples / (double) (eventsToAdd.getLastEventTime() + 1 - firstEventToAdd);
 
-        while (i2.getNextEvent (message, time))
+        while (i2.getNextEvent (data, size, time))
         {
             const int pos = jlimit (0, numSamples - 1, roundToInt ((time - firstEventToAdd) * scaleFactor));
-            buffer.addEvent (message, startSample + pos);
+            buffer.addEvent (data, size, startSample + pos);
         }
     }
 
@@ -151,12 +151,13 @@ void Synthesiser::renderNextBlock (AudioSampleBuffer& outputBuffer,
 
     MidiBuffer::Iterator midiIterator (midiData);
     midiIterator.setNextSamplePosition (startSample);
-    MidiMessage m (0xf4, 0.0);
 
     while (numSamples > 0)
     {
-        int midiEventPos;
-        const bool useEvent = midiIterator.getNextEvent (m, midiEventPos)
+        // (the events are read in place, and only made into MidiMessages if they're used)
+        const uint8* midiEventData;
+        int midiEventSize, midiEventPos;
+        const bool useEvent = midiIterator.getNextEvent (midiEventData, midiEventSize, midiEventPos)
                                 && midiEventPos < startSample + numSamples;
 
         const int numThisTime = useEvent ? midiEventPos - startSample
@@ -169,7 +170,7 @@ void Synthesiser::renderNextBlock (AudioSampleBuffer& outputBuffer,
         }
 
         if (useEvent)
-            handleMidiEvent (m);
+            handleMidiEvent (MidiMessage (midiEventData, midiEventSize, midiEventPos));
 
         startSample += numThisTime;
         numSamples -= numThisTime;
@@ -28,6 +28,18 @@ const int AudioProcessorGraph::midiChannelIndex = 0x1000;
 namespace GraphRenderingOps
 {
 
+//==============================================================================
+/** The shared buffers that a rendering op reads and writes, used to work out
+    which ops can safely be run in parallel.
+*/
+struct RenderingOpUsage
+{
+    RenderingOpUsage() : usesGraphIO (false) {}
+
+    Array<int> audioReads, audioWrites, midiReads, midiWrites;
+    bool usesGraphIO;
+};
+
 //==============================================================================
 class AudioGraphRenderingOp
 {
@@ -39,6 +51,8 @@ public:
                           const OwnedArray <MidiBuffer>& sharedMidiBuffers,
                           const int numSamples) = 0;
 
+    virtual void getUsage (RenderingOpUsage& usage) const = 0;
+
     JUCE_LEAK_DETECTOR (AudioGraphRenderingOp)
 };
 
@@ -55,6 +69,11 @@ public:
         sharedBufferChans.clear (channelNum, 0, numSamples);
     }
 
+    void getUsage (RenderingOpUsage& usage) const
+    {
+        usage.audioWrites.add (channelNum);
+    }
+
 private:
     const int channelNum;
 
@@ -75,6 +94,12 @@ public:
         sharedBufferChans.copyFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    void getUsage (RenderingOpUsage& usage) const
+    {
+        usage.audioReads.add (srcChannelNum);
+        usage.audioWrites.add (dstChannelNum);
+    }
+
 private:
     const int srcChannelNum, dstChannelNum;
 
@@ -95,6 +120,12 @@ public:
         sharedBufferChans.addFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    void getUsage (RenderingOpUsage& usage) const
+    {
+        usage.audioReads.add (srcChannelNum);
+        usage.audioWrites.add (dstChannelNum);
+    }
+
 private:
     const int srcChannelNum, dstChannelNum;
 
@@ -114,6 +145,11 @@ public:
         sharedMidiBuffers.getUnchecked (bufferNum)->clear();
     }
 
+    void getUsage (RenderingOpUsage& usage) const
+    {
+        usage.midiWrites.add (bufferNum);
+    }
+
 private:
     const int bufferNum;
 
@@ -134,6 +170,12 @@ public:
         *sharedMidiBuffers.getUnchecked (dstBufferNum) = *sharedMidiBuffers.getUnchecked (srcBufferNum);
     }
 
+    void getUsage (RenderingOpUsage& usage) const
+    {
+        usage.midiReads.add (srcBufferNum);
+        usage.midiWrites.add (dstBufferNum);
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -155,6 +197,12 @@ public:
             ->addEvents (*sharedMidiBuffers.getUnchecked (srcBufferNum), 0, numSamples, 0);
     }
 
+    void getUsage (RenderingOpUsage& usage) const
+    {
+        usage.midiReads.add (srcBufferNum);
+        usage.midiWrites.add (dstBufferNum);
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -187,6 +235,11 @@ public:
         }
     }
 
+    void getUsage (RenderingOpUsage& usage) const
+    {
+        usage.audioWrites.add (channel);
+    }
+
 private:
     HeapBlock<float> buffer;
     const int channel, bufferSize;
@@ -226,6 +279,25 @@ public:
         processor->processBlock (buffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
     }
 
+    void getUsage (RenderingOpUsage& usage) const
+    {
+        // channel 0 is the shared buffer of silence, which processors are only given to read
+        for (int i = 0; i < totalChans; ++i)
+        {
+            const int chan = audioChannelsToUse.getUnchecked (i);
+
+            if (chan == 0)
+                usage.audioReads.addIfNotAlreadyThere (chan);
+            else
+                usage.audioWrites.addIfNotAlreadyThere (chan);
+        }
+
+        usage.midiWrites.add (midiBufferToUse);
+
+        // the graph's own i/o buffers are shared by all the i/o nodes
+        usage.usesGraphIO = dynamic_cast<AudioProcessorGraph::AudioGraphIOProcessor*> (processor) != nullptr;
+    }
+
     const AudioProcessorGraph::Node::Ptr node;
     AudioProcessor* const processor;
 
@@ -248,10 +320,12 @@ public:
     //==============================================================================
     RenderingOpSequenceCalculator (AudioProcessorGraph& graph_,
                                    const Array<void*>& orderedNodes_,
-                                   Array<void*>& renderingOps)
+                                   Array<void*>& renderingOps,
+                                   const bool reuseFreeBuffers_ = true)
         : graph (graph_),
           orderedNodes (orderedNodes_),
-          totalLatency (0)
+          totalLatency (0),
+          reuseFreeBuffers (reuseFreeBuffers_)
     {
         nodeIds.add ((uint32) zeroNodeID); // first buffer is read-only zeros
         channels.add (0);
@@ -286,6 +360,7 @@ private:
     Array <uint32> nodeDelayIDs;
     Array <int> nodeDelays;
     int totalLatency;
+    const bool reuseFreeBuffers;
 
     int getNodeDelay (const uint32 nodeID) const          { return nodeDelays [nodeDelayIDs.indexOf (nodeID)]; }
 
@@ -619,18 +694,20 @@ private:
     {
         if (forMidi)
         {
-            for (int i = 1; i < midiNodeIds.size(); ++i)
-                if (midiNodeIds.getUnchecked(i) == freeNodeID)
-                    return i;
+            if (reuseFreeBuffers)
+                for (int i = 1; i < midiNodeIds.size(); ++i)
+                    if (midiNodeIds.getUnchecked(i) == freeNodeID)
+                        return i;
 
             midiNodeIds.add ((uint32) freeNodeID);
             return midiNodeIds.size() - 1;
         }
         else
         {
-            for (int i = 1; i < nodeIds.size(); ++i)
-                if (nodeIds.getUnchecked(i) == freeNodeID)
-                    return i;
+            if (reuseFreeBuffers)
+                for (int i = 1; i < nodeIds.size(); ++i)
+                    if (nodeIds.getUnchecked(i) == freeNodeID)
+                        return i;
 
             nodeIds.add ((uint32) freeNodeID);
             channels.add (0);
@@ -739,6 +816,357 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderingOpSequenceCalculator)
 };
 
+//==============================================================================
+/** The rendering ops grouped into one task per node, with the dependencies
+    between tasks found from the shared buffers that their ops use.
+
+    A task depends on an earlier one if it reads something the earlier one writes,
+    or writes something the earlier one reads or writes, so running the tasks in any
+    order that respects the dependencies gives the same result as running the ops
+    one after another.
+*/
+class RenderingSchedule
+{
+public:
+    RenderingSchedule (const Array<void*>& renderingOps,
+                       const int numAudioBuffers, const int numMidiBuffers)
+    {
+        // resources are numbered as audio channels, then midi buffers, then the graph's i/o
+        const int numResources = numAudioBuffers + numMidiBuffers + 1;
+        const int graphIOResource = numResources - 1;
+
+        Array<int> lastWriter;
+        OwnedArray<Array<int> > readersSinceWrite;
+
+        for (int i = 0; i < numResources; ++i)
+        {
+            lastWriter.add (-1);
+            readersSinceWrite.add (new Array<int>());
+        }
+
+        Task* task = nullptr;
+
+        for (int i = 0; i < renderingOps.size(); ++i)
+        {
+            AudioGraphRenderingOp* const op = (AudioGraphRenderingOp*) renderingOps.getUnchecked(i);
+
+            if (task == nullptr)
+                task = tasks.add (new Task());
+
+            const int taskIndex = tasks.size() - 1;
+            task->ops.add (op);
+
+            RenderingOpUsage usage;
+            op->getUsage (usage);
+
+            Array<int> reads, writes;
+
+            for (int j = 0; j < usage.audioReads.size(); ++j)   reads.add (usage.audioReads.getUnchecked (j));
+            for (int j = 0; j < usage.audioWrites.size(); ++j)  writes.add (usage.audioWrites.getUnchecked (j));
+            for (int j = 0; j < usage.midiReads.size(); ++j)    reads.add (numAudioBuffers + usage.midiReads.getUnchecked (j));
+            for (int j = 0; j < usage.midiWrites.size(); ++j)   writes.add (numAudioBuffers + usage.midiWrites.getUnchecked (j));
+
+            if (usage.usesGraphIO)
+                writes.add (graphIOResource);
+
+            for (int j = 0; j < reads.size(); ++j)
+            {
+                const int resource = reads.getUnchecked (j);
+                jassert (isPositiveAndBelow (resource, numResources));
+
+                addDependency (taskIndex, lastWriter.getUnchecked (resource));
+                readersSinceWrite.getUnchecked (resource)->addIfNotAlreadyThere (taskIndex);
+            }
+
+            for (int j = 0; j < writes.size(); ++j)
+            {
+                const int resource = writes.getUnchecked (j);
+                jassert (isPositiveAndBelow (resource, numResources));
+
+                Array<int>& readers = *readersSinceWrite.getUnchecked (resource);
+
+                for (int k = 0; k < readers.size(); ++k)
+                    addDependency (taskIndex, readers.getUnchecked (k));
+
+                addDependency (taskIndex, lastWriter.getUnchecked (resource));
+                lastWriter.set (resource, taskIndex);
+                readers.clearQuick();
+            }
+
+            // each node's ops end with its ProcessBufferOp
+            if (dynamic_cast<ProcessBufferOp*> (op) != nullptr)
+                task = nullptr;
+        }
+
+        for (int i = 0; i < tasks.size(); ++i)
+        {
+            Task& t = *tasks.getUnchecked (i);
+
+            for (int j = 0; j < t.dependencies.size(); ++j)
+                tasks.getUnchecked (t.dependencies.getUnchecked (j))->dependents.add (i);
+
+            if (t.dependencies.size() == 0)
+                initialTasks.add (i);
+        }
+
+        readyQueue.calloc ((size_t) jmax (1, tasks.size()));
+    }
+
+    //==============================================================================
+    struct Task
+    {
+        Array<AudioGraphRenderingOp*> ops;
+        SortedSet<int> dependencies;
+        Array<int> dependents;
+        Atomic<int> numPendingDependencies;
+    };
+
+    int getNumTasks() const noexcept        { return tasks.size(); }
+
+    /** Gets ready to render a block - called before any workers are started on it. */
+    void reset() noexcept
+    {
+        for (int i = tasks.size(); --i >= 0;)
+        {
+            Task& t = *tasks.getUnchecked (i);
+            t.numPendingDependencies.set (t.dependencies.size());
+        }
+
+        zeromem (readyQueue, sizeof (Atomic<int>) * (size_t) jmax (1, tasks.size()));
+        readIndex.set (0);
+        writeIndex.set (0);
+        numTasksDone.set (0);
+
+        for (int i = 0; i < initialTasks.size(); ++i)
+            pushReadyTask (initialTasks.getUnchecked (i));
+    }
+
+    /** Runs the next task that's ready, if there is one. Safe to call from any number of threads. */
+    bool performNextTask (AudioSampleBuffer& sharedBufferChans,
+                          const OwnedArray <MidiBuffer>& sharedMidiBuffers,
+                          const int numSamples) noexcept
+    {
+        const int index = readIndex.get();
+
+        if (index >= writeIndex.get() || ! readIndex.compareAndSetBool (index + 1, index))
+            return false;
+
+        // the slot has been claimed, but the task may still be in the process of being written
+        int taskIndex;
+        while ((taskIndex = readyQueue[index].get()) == 0)
+        {}
+
+        Task& task = *tasks.getUnchecked (taskIndex - 1);
+
+        for (int i = 0; i < task.ops.size(); ++i)
+            task.ops.getUnchecked (i)->perform (sharedBufferChans, sharedMidiBuffers, numSamples);
+
+        for (int i = 0; i < task.dependents.size(); ++i)
+        {
+            const int dependent = task.dependents.getUnchecked (i);
+
+            if (--(tasks.getUnchecked (dependent)->numPendingDependencies) == 0)
+                pushReadyTask (dependent);
+        }
+
+        ++numTasksDone;
+        return true;
+    }
+
+    bool isFinished() const noexcept        { return numTasksDone.get() >= tasks.size(); }
+
+private:
+    OwnedArray<Task> tasks;
+    Array<int> initialTasks;
+
+    // each task becomes ready exactly once per block, so this never needs to wrap
+    HeapBlock<Atomic<int> > readyQueue;
+    Atomic<int> readIndex, writeIndex, numTasksDone;
+
+    void addDependency (const int taskIndex, const int dependsOn)
+    {
+        if (dependsOn >= 0 && dependsOn != taskIndex)
+            tasks.getUnchecked (taskIndex)->dependencies.add (dependsOn);
+    }
+
+    void pushReadyTask (const int taskIndex) noexcept
+    {
+        const int index = (writeIndex += 1) - 1;
+        readyQueue[index].set (taskIndex + 1);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (RenderingSchedule)
+};
+
+//==============================================================================
+/** A pool of worker threads that render a RenderingSchedule along with the
+    thread that calls perform().
+
+    The calling (audio) thread bumps a block counter, which the workers poll.
+    Each worker spins (yielding) for a couple of milliseconds after a block, then
+    parks, blocking on its own WaitableEvent until perform() signals it. perform()
+    only signals the workers that have parked (so not while blocks follow each
+    other within the spin time), and a woken worker may join a block late, or not
+    at all, but never holds it up.
+*/
+class ParallelRenderer
+{
+public:
+    ParallelRenderer (const int numWorkers)
+        : schedule (nullptr), sharedBuffer (nullptr), sharedMidi (nullptr), numSamplesToRender (0)
+    {
+        blockFinished.set (1);
+
+        const int numCpus = jmin (32, SystemStats::getNumCpus());
+
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            Worker* const worker = workers.add (new Worker (*this, i));
+            worker->startThread (9);
+
+            // leave the first CPU to the thread that calls us (any workers
+            // beyond the other CPUs are left to the scheduler)
+            if (i + 1 < numCpus)
+                worker->setAffinityMask ((uint32) 1 << (i + 1));
+        }
+    }
+
+    ~ParallelRenderer()
+    {
+        for (int i = workers.size(); --i >= 0;)
+            workers.getUnchecked (i)->signalThreadShouldExit();
+
+        for (int i = workers.size(); --i >= 0;)
+            workers.getUnchecked (i)->wakeUp.signal();  // (wake any that are parked)
+
+        workers.clear();
+    }
+
+    int getNumWorkers() const noexcept      { return workers.size(); }
+
+    void perform (RenderingSchedule& scheduleToRender,
+                  AudioSampleBuffer& sharedBufferChans,
+                  const OwnedArray <MidiBuffer>& sharedMidiBuffers,
+                  const int numSamples)
+    {
+        schedule = &scheduleToRender;
+        sharedBuffer = &sharedBufferChans;
+        sharedMidi = &sharedMidiBuffers;
+        numSamplesToRender = numSamples;
+        schedule->reset();
+
+        blockFinished.set (0);
+        ++blockNumber;
+
+        // wake any workers that have parked since the last block
+        for (int i = workers.size(); --i >= 0;)
+        {
+            Worker* const worker = workers.getUnchecked (i);
+
+            if (worker->parked.compareAndSetBool (0, 1))
+                worker->wakeUp.signal();
+        }
+
+        render();
+
+        // wait for any workers that joined in to let go of the schedule
+        blockFinished.set (1);
+
+        while (numActiveWorkers.get() > 0)
+            Thread::yield();
+    }
+
+private:
+    //==============================================================================
+    class Worker  : public Thread
+    {
+    public:
+        Worker (ParallelRenderer& owner_, const int index)
+            : Thread ("Graph Rendering Thread " + String (index + 1)),
+              owner (owner_)
+        {}
+
+        WaitableEvent wakeUp;
+        Atomic<int> parked;     // set while the worker is (about to be) blocked on wakeUp
+
+        ~Worker()
+        {
+            stopThread (1000);
+        }
+
+        void run()
+        {
+            int lastBlock = owner.blockNumber.get();
+            uint32 idleSince = Time::getMillisecondCounter();
+
+            while (! threadShouldExit())
+            {
+                const int block = owner.blockNumber.get();
+
+                if (block == lastBlock)
+                {
+                    if (Time::getMillisecondCounter() - idleSince < spinMilliseconds)
+                    {
+                        Thread::yield();
+                    }
+                    else
+                    {
+                        // park, unless a block started since we last looked (perform()
+                        // bumps the block number before it checks whether we're parked)
+                        parked.set (1);
+
+                        if (owner.blockNumber.get() == lastBlock)
+                            wakeUp.wait (-1);
+                        else if (! parked.compareAndSetBool (0, 1))
+                            wakeUp.wait (-1);   // (perform() has signalled us already)
+
+                        parked.set (0);
+                    }
+
+                    continue;
+                }
+
+                lastBlock = block;
+
+                ++(owner.numActiveWorkers);
+
+                // if the block was finished before we got here, there's nothing to do
+                if (owner.blockFinished.get() == 0)
+                    owner.render();
+
+                --(owner.numActiveWorkers);
+
+                idleSince = Time::getMillisecondCounter();
+            }
+        }
+
+    private:
+        ParallelRenderer& owner;
+
+        enum { spinMilliseconds = 2 };
+
+        JUCE_DECLARE_NON_COPYABLE (Worker)
+    };
+
+    OwnedArray<Worker> workers;
+
+    RenderingSchedule* schedule;
+    AudioSampleBuffer* sharedBuffer;
+    const OwnedArray <MidiBuffer>* sharedMidi;
+    int numSamplesToRender;
+
+    Atomic<int> blockFinished, blockNumber, numActiveWorkers;
+
+    void render() noexcept
+    {
+        while (! schedule->isFinished())
+            if (! schedule->performNextTask (*sharedBuffer, *sharedMidi, numSamplesToRender))
+                Thread::yield();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ParallelRenderer)
+};
+
 //==============================================================================
 // Holds a fast lookup table for checking which nodes are inputs to others.
 class ConnectionLookupTable
@@ -933,6 +1361,7 @@ AudioProcessorGraph::AudioProcessorGraph()
 AudioProcessorGraph::~AudioProcessorGraph()
 {
     clearRenderingSequence();
+    parallelRenderer = nullptr;
     clear();
 }
 
@@ -1177,15 +1606,41 @@ static void deleteRenderOpArray (Array<void*>& ops)
 void AudioProcessorGraph::clearRenderingSequence()
 {
     Array<void*> oldOps;
+    ScopedPointer<GraphRenderingOps::RenderingSchedule> oldSchedule;
 
     {
         const ScopedLock sl (getCallbackLock());
         renderingOps.swapWith (oldOps);
+        renderingSchedule.swapWith (oldSchedule);
     }
 
     deleteRenderOpArray (oldOps);
 }
 
+void AudioProcessorGraph::setNumRenderingThreads (const int numWorkerThreads)
+{
+    if (numWorkerThreads == getNumRenderingThreads())
+        return;
+
+    ScopedPointer<GraphRenderingOps::ParallelRenderer> newRenderer;
+
+    if (numWorkerThreads > 0)
+        newRenderer = new GraphRenderingOps::ParallelRenderer (numWorkerThreads);
+
+    {
+        const ScopedLock sl (getCallbackLock());
+        parallelRenderer.swapWith (newRenderer);
+    }
+
+    // the buffers need to be allocated differently for parallel rendering
+    triggerAsyncUpdate();
+}
+
+int AudioProcessorGraph::getNumRenderingThreads() const noexcept
+{
+    return parallelRenderer != nullptr ? parallelRenderer->getNumWorkers() : 0;
+}
+
 bool AudioProcessorGraph::isAnInputTo (const uint32 possibleInputId,
                                        const uint32 possibleDestinationId,
                                        const int recursionCheck) const
@@ -1209,6 +1664,7 @@ bool AudioProcessorGraph::isAnInputTo (const uint32 possibleInputId,
 void AudioProcessorGraph::buildRenderingSequence()
 {
     Array<void*> newRenderingOps;
+    ScopedPointer<GraphRenderingOps::RenderingSchedule> newSchedule;
     int numRenderingBuffersNeeded = 2;
     int numMidiBuffersNeeded = 1;
 
@@ -1235,10 +1691,18 @@ void AudioProcessorGraph::buildRenderingSequence()
             }
         }
 
-        GraphRenderingOps::RenderingOpSequenceCalculator calculator (*this, orderedNodes, newRenderingOps);
+        const bool renderInParallel = parallelRenderer != nullptr;
+
+        GraphRenderingOps::RenderingOpSequenceCalculator calculator (*this, orderedNodes, newRenderingOps,
+                                                                     ! renderInParallel);
 
         numRenderingBuffersNeeded = calculator.getNumBuffersNeeded();
         numMidiBuffersNeeded = calculator.getNumMidiBuffersNeeded();
+
+        if (renderInParallel)
+            newSchedule = new GraphRenderingOps::RenderingSchedule (newRenderingOps,
+                                                                    numRenderingBuffersNeeded,
+                                                                    numMidiBuffersNeeded);
     }
 
     {
@@ -1255,6 +1719,7 @@ void AudioProcessorGraph::buildRenderingSequence()
             midiBuffers.add (new MidiBuffer());
 
         renderingOps.swapWith (newRenderingOps);
+        renderingSchedule.swapWith (newSchedule);
     }
 
     // delete the old ones..
@@ -1310,12 +1775,19 @@ void AudioProcessorGraph::processBlock (AudioSampleBuffer& buffer, MidiBuffer& m
     currentMidiInputBuffer = &midiMessages;
     currentMidiOutputBuffer.clear();
 
-    for (int i = 0; i < renderingOps.size(); ++i)
+    if (parallelRenderer != nullptr && renderingSchedule != nullptr)
+    {
+        parallelRenderer->perform (*renderingSchedule, renderingBuffers, midiBuffers, numSamples);
+    }
+    else
     {
-        GraphRenderingOps::AudioGraphRenderingOp* const op
-            = (GraphRenderingOps::AudioGraphRenderingOp*) renderingOps.getUnchecked(i);
+        for (int i = 0; i < renderingOps.size(); ++i)
+        {
+            GraphRenderingOps::AudioGraphRenderingOp* const op
+                = (GraphRenderingOps::AudioGraphRenderingOp*) renderingOps.getUnchecked(i);
 
-        op->perform (renderingBuffers, midiBuffers, numSamples);
+            op->perform (renderingBuffers, midiBuffers, numSamples);
+        }
     }
 
     for (int i = 0; i < buffer.getNumChannels(); ++i)
@@ -29,6 +29,7 @@
 #include "../format/juce_AudioPluginFormatManager.h"
 #include "../scanning/juce_KnownPluginList.h"
 
+namespace GraphRenderingOps { class RenderingSchedule; class ParallelRenderer; }
 
 //==============================================================================
 /**
@@ -255,6 +256,26 @@ public:
     */
     static const int midiChannelIndex;
 
+    //==============================================================================
+    /** Enables rendering independent branches of the graph in parallel.
+
+        By default, all the nodes are processed one after another on the thread that
+        calls processBlock(). If this is given a number of worker threads, the graph is
+        analysed to find which nodes don't depend on each other, and these are processed
+        concurrently by the workers and the calling thread.
+
+        Each worker is started at a high priority and pinned to its own CPU, and the
+        workers never take any locks while a block is being rendered. In this mode every
+        node's output is given its own channel in the shared rendering buffer, so parallel
+        branches can never overwrite each other's data, at the cost of some extra memory.
+
+        Pass 0 to go back to processing all the nodes on the calling thread.
+    */
+    void setNumRenderingThreads (int numWorkerThreads);
+
+    /** Returns the number of worker threads set with setNumRenderingThreads(). */
+    int getNumRenderingThreads() const noexcept;
+
 
     //==============================================================================
     /** A special type of AudioProcessor that can live inside an AudioProcessorGraph
@@ -398,6 +419,8 @@ private:
     AudioSampleBuffer renderingBuffers;
     OwnedArray <MidiBuffer> midiBuffers;
     Array<void*> renderingOps;
+    ScopedPointer<GraphRenderingOps::RenderingSchedule> renderingSchedule;
+    ScopedPointer<GraphRenderingOps::ParallelRenderer> parallelRenderer;
 
     friend class AudioGraphIOProcessor;
     AudioSampleBuffer* currentAudioInputBuffer;
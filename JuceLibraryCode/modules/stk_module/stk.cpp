@@ -89,6 +89,9 @@
 #include "stk/Drummer.cpp"
 #include "stk/Echo.cpp"
 #include "stk/Envelope.cpp"
+#include "stk/FastFir.cpp"
+#include "stk/FastMesh2D.cpp"
+#include "stk/FastTapDelay.cpp"
 #include "stk/FileLoop.cpp"
 #include "stk/FileRead.cpp"
 #include "stk/FileWrite.cpp"
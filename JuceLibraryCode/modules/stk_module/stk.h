@@ -86,6 +86,9 @@
 #include "stk/Echo.h"
 #include "stk/Effect.h"
 #include "stk/Envelope.h"
+#include "stk/FastFir.h"
+#include "stk/FastMesh2D.h"
+#include "stk/FastTapDelay.h"
 #include "stk/FileLoop.h"
 #include "stk/FileRead.h"
 #include "stk/FileWrite.h"
@@ -143,6 +146,7 @@
 #include "stk/TwoPole.h"
 #include "stk/TwoZero.h"
 #include "stk/Vector3D.h"
+#include "stk/VectorOps.h"
 #include "stk/Voicer.h"
 #include "stk/VoicForm.h"
 #include "stk/Whistle.h"
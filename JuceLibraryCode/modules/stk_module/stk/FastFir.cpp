@@ -0,0 +1,90 @@
+/***************************************************/
+/*! \class FastFir
+    \brief STK vectorised finite impulse response filter class.
+
+    This class computes the same difference equation as the Fir
+    class, with the same interface, but much faster for long filters.
+    Rather than shifting every past input along by one sample per
+    tick, the inputs are kept in a ring buffer which is written twice
+    (its second half mirrors the first), so the last N inputs are
+    always contiguous in memory.  Each output is then a single dot
+    product with the reversed coefficients, computed with AVX or SSE
+    where available (see vectorops).
+
+    y[n] = b[0]*x[n] + ... + b[nb]*x[n-nb]
+
+    The \e gain parameter is applied at the filter input and does not
+    affect the coefficient values.  The default gain value is 1.0.
+
+    Based on the STK Fir class, by Perry R. Cook and Gary P.
+    Scavone, 1995-2012 (not part of the STK distribution).
+*/
+/***************************************************/
+
+#include "FastFir.h"
+
+namespace stk {
+
+// The length is padded to a multiple of this (with zero coefficients).
+const unsigned int VECTOR_SIZE = 8;
+
+FastFir :: FastFir()
+  : length_( 0 ), position_( 0 )
+{
+  // The default constructor should setup for pass-through.
+  std::vector<StkFloat> coefficients( 1, 1.0 );
+  this->setCoefficients( coefficients, true );
+}
+
+FastFir :: FastFir( std::vector<StkFloat> &coefficients )
+  : length_( 0 ), position_( 0 )
+{
+  // Check the arguments.
+  if ( coefficients.size() == 0 ) {
+    oStream_ << "FastFir: coefficient vector must have size > 0!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  this->setCoefficients( coefficients, true );
+}
+
+FastFir :: ~FastFir()
+{
+}
+
+void FastFir :: setCoefficients( std::vector<StkFloat> &coefficients, bool clearState )
+{
+  // Check the argument.
+  if ( coefficients.size() == 0 ) {
+    oStream_ << "FastFir::setCoefficients: coefficient vector must have size > 0!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  b_ = coefficients;
+
+  unsigned int length = ( b_.size() + VECTOR_SIZE - 1 ) / VECTOR_SIZE * VECTOR_SIZE;
+  if ( length != length_ ) {
+    length_ = length;
+    history_.resize( 2 * length_ );
+    clearState = true;
+  }
+
+  // The coefficients are reversed to match the order of the inputs
+  // in memory (oldest first), so each output is one dot product.
+  reversed_.assign( length_, 0.0 );
+  for ( unsigned int i=0; i<b_.size(); i++ )
+    reversed_[length_ - 1 - i] = b_[i];
+
+  if ( clearState ) this->clear();
+}
+
+void FastFir :: clear( void )
+{
+  for ( unsigned int i=0; i<history_.size(); i++ )
+    history_[i] = 0.0;
+  for ( unsigned int i=0; i<lastFrame_.size(); i++ )
+    lastFrame_[i] = 0.0;
+  position_ = 0;
+}
+
+} // stk namespace
@@ -0,0 +1,167 @@
+#ifndef STK_FASTFIR_H
+#define STK_FASTFIR_H
+
+#include "Filter.h"
+#include "VectorOps.h"
+
+namespace stk {
+
+/***************************************************/
+/*! \class FastFir
+    \brief STK vectorised finite impulse response filter class.
+
+    This class computes the same difference equation as the Fir
+    class, with the same interface, but much faster for long filters.
+    Rather than shifting every past input along by one sample per
+    tick, the inputs are kept in a ring buffer which is written twice
+    (its second half mirrors the first), so the last N inputs are
+    always contiguous in memory.  Each output is then a single dot
+    product with the reversed coefficients, computed with AVX or SSE
+    where available (see vectorops).
+
+    y[n] = b[0]*x[n] + ... + b[nb]*x[n-nb]
+
+    The \e gain parameter is applied at the filter input and does not
+    affect the coefficient values.  The default gain value is 1.0.
+
+    Based on the STK Fir class, by Perry R. Cook and Gary P.
+    Scavone, 1995-2012 (not part of the STK distribution).
+*/
+/***************************************************/
+
+class FastFir : public Filter
+{
+public:
+  //! Default constructor creates a zero-order pass-through "filter".
+  FastFir( void );
+
+  //! Overloaded constructor which takes filter coefficients.
+  /*!
+    An StkError can be thrown if the coefficient vector size is
+    zero.
+  */
+  FastFir( std::vector<StkFloat> &coefficients );
+
+  //! Class destructor.
+  ~FastFir( void );
+
+  //! Set filter coefficients.
+  /*!
+    An StkError can be thrown if the coefficient vector size is
+    zero.  The internal state of the filter is not cleared unless the
+    \e clearState flag is \c true (or the filter's length changes).
+  */
+  void setCoefficients( std::vector<StkFloat> &coefficients, bool clearState = false );
+
+  //! Clears all internal states of the filter.
+  void clear( void );
+
+  //! Return the last computed output value.
+  StkFloat lastOut( void ) const { return lastFrame_[0]; };
+
+  //! Input one sample to the filter and return one output.
+  StkFloat tick( StkFloat input );
+
+  //! Take a channel of the StkFrames object as inputs to the filter and replace with corresponding outputs.
+  /*!
+    The StkFrames argument reference is returned.  The \c channel
+    argument must be less than the number of channels in the
+    StkFrames argument (the first channel is specified by 0).
+    However, range checking is only performed if _STK_DEBUG_ is
+    defined during compilation, in which case an out-of-range value
+    will trigger an StkError exception.
+  */
+  StkFrames& tick( StkFrames& frames, unsigned int channel = 0 );
+
+  //! Take a channel of the \c iFrames object as inputs to the filter and write outputs to the \c oFrames object.
+  /*!
+    The \c iFrames object reference is returned.  Each channel
+    argument must be less than the number of channels in the
+    corresponding StkFrames argument (the first channel is specified
+    by 0).  However, range checking is only performed if _STK_DEBUG_
+    is defined during compilation, in which case an out-of-range value
+    will trigger an StkError exception.
+  */
+  StkFrames& tick( StkFrames& iFrames, StkFrames &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
+
+  //! Filter \c nFrames samples from \c input to \c output, which may be the same array.
+  void tick( const StkFloat *input, StkFloat *output, unsigned int nFrames );
+
+protected:
+
+  StkFloat process( StkFloat input );
+
+  // The filter length, rounded up to a whole number of vectors.
+  unsigned int length_;
+
+  // The newest input is at position_ (and position_ + length_).
+  unsigned int position_;
+
+  std::vector<StkFloat> history_;
+  std::vector<StkFloat> reversed_;
+
+};
+
+inline StkFloat FastFir :: process( StkFloat input )
+{
+  if ( ++position_ == length_ ) position_ = 0;
+  history_[position_] = history_[position_ + length_] = gain_ * input;
+
+  // The oldest input is just after the newest.
+  return vectorops::dotProduct( &reversed_[0], &history_[position_ + 1], length_ );
+}
+
+inline StkFloat FastFir :: tick( StkFloat input )
+{
+  lastFrame_[0] = process( input );
+  return lastFrame_[0];
+}
+
+inline StkFrames& FastFir :: tick( StkFrames& frames, unsigned int channel )
+{
+#if defined(_STK_DEBUG_)
+  if ( channel >= frames.channels() ) {
+    oStream_ << "FastFir::tick(): channel and StkFrames arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  StkFloat *samples = &frames[channel];
+  unsigned int hop = frames.channels();
+  for ( unsigned int i=0; i<frames.frames(); i++, samples += hop )
+    *samples = process( *samples );
+
+  lastFrame_[0] = *(samples-hop);
+  return frames;
+}
+
+inline StkFrames& FastFir :: tick( StkFrames& iFrames, StkFrames& oFrames, unsigned int iChannel, unsigned int oChannel )
+{
+#if defined(_STK_DEBUG_)
+  if ( iChannel >= iFrames.channels() || oChannel >= oFrames.channels() ) {
+    oStream_ << "FastFir::tick(): channel and StkFrames arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  StkFloat *iSamples = &iFrames[iChannel];
+  StkFloat *oSamples = &oFrames[oChannel];
+  unsigned int iHop = iFrames.channels(), oHop = oFrames.channels();
+  for ( unsigned int i=0; i<iFrames.frames(); i++, iSamples += iHop, oSamples += oHop )
+    *oSamples = process( *iSamples );
+
+  lastFrame_[0] = *(oSamples-oHop);
+  return iFrames;
+}
+
+inline void FastFir :: tick( const StkFloat *input, StkFloat *output, unsigned int nFrames )
+{
+  for ( unsigned int i=0; i<nFrames; i++ )
+    output[i] = process( input[i] );
+
+  if ( nFrames > 0 ) lastFrame_[0] = output[nFrames-1];
+}
+
+} // stk namespace
+
+#endif
@@ -0,0 +1,213 @@
+/***************************************************/
+/*! \class FastMesh2D
+    \brief Vectorised two-dimensional rectilinear waveguide mesh class.
+
+    This class implements the same rectilinear, two-dimensional
+    digital waveguide mesh as the Mesh2D class, with the same
+    interface, but for meshes of up to 64 x 64 junctions (set at run
+    time), and much faster.
+
+    The four wave variables of each row of the mesh are stored next to
+    each other, in rows padded to whole cache lines, so that updating
+    a row of junctions reads and writes a few neighbouring lines.
+    Each row is updated by one vectorised kernel (see vectorops), and
+    the two sets of wave variables are swapped by pointer, rather than
+    by alternating tick functions.  The one-pole boundary filters
+    share their coefficients, with their states held in arrays.
+
+    Memory for the largest mesh is allocated on construction, so the
+    dimensions can be changed while running.  The mesh is cleared if
+    the y dimension changes the length of its rows in memory.
+
+    This is a digital waveguide model, making its
+    use possibly subject to patents held by Stanford
+    University, Yamaha, and others.
+
+    Control Change Numbers:
+       - X Dimension = 2
+       - Y Dimension = 4
+       - Mesh Decay = 11
+       - X-Y Input Position = 1
+
+    Based on the STK Mesh2D class, by Perry R. Cook and Gary P.
+    Scavone, 1995-2012 (not part of the STK distribution).
+*/
+/***************************************************/
+
+#include "FastMesh2D.h"
+#include "SKINI.msg"
+
+namespace stk {
+
+// Rows are padded to (and aligned on) multiples of this many bytes.
+const unsigned int CACHE_LINE = 64;
+const unsigned int LINE_SIZE = CACHE_LINE / sizeof( StkFloat );
+
+FastMesh2D :: FastMesh2D( unsigned short nX, unsigned short nY )
+  : NX_( 2 ), NY_( 2 ), xInput_( 0 ), yInput_( 0 ), stride_( LINE_SIZE )
+{
+  if ( nX == 0 || nY == 0 ) {
+    oStream_ << "FastMesh2D::FastMesh2D: one or more argument is equal to zero!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  // Two sets of wave variables for the largest mesh, plus room to align them.
+  unsigned int setSize = MAX_SIZE * WAVES * ( ( MAX_SIZE + LINE_SIZE - 1 ) / LINE_SIZE * LINE_SIZE );
+  storage_.resize( 2 * setSize + LINE_SIZE );
+  size_t misalignment = (size_t) &storage_[0] % CACHE_LINE;
+  rows_[0] = &storage_[0] + ( misalignment ? ( CACHE_LINE - misalignment ) / sizeof( StkFloat ) : 0 );
+  rows_[1] = rows_[0] + setSize;
+
+  this->setNX( nX );
+  this->setNY( nY );
+
+  // The boundary filters (as Mesh2D's OnePole filters, with a pole of 0.05).
+  StkFloat pole = 0.05;
+  b0_ = (StkFloat) ( 1.0 - pole );
+  a1_ = -pole;
+  gain_ = 0.99;
+
+  this->clear();
+}
+
+FastMesh2D :: ~FastMesh2D( void )
+{
+}
+
+void FastMesh2D :: clear( void )
+{
+  this->clearMesh();
+
+  for ( unsigned int i=0; i<MAX_SIZE; i++ )
+    filterX_[i] = filterY_[i] = 0.0;
+}
+
+void FastMesh2D :: clearMesh( void )
+{
+  for ( unsigned int i=0; i<storage_.size(); i++ )
+    storage_[i] = 0.0;
+}
+
+StkFloat FastMesh2D :: energy( void )
+{
+  // Return total energy contained in wave variables Note that some
+  // energy is also contained in any filter delay elements.
+  StkFloat e = 0;
+  for ( unsigned int x=0; x<NX_; x++ ) {
+    for ( int i=0; i<WAVES; i++ ) {
+      StkFloat *w = wave( 0, x, i );
+      e += vectorops::dotProduct( w, w, NY_ );
+    }
+  }
+
+  return e;
+}
+
+void FastMesh2D :: setNX( unsigned short lenX )
+{
+  if ( lenX < 2 ) {
+    oStream_ << "FastMesh2D::setNX(" << lenX << "): Minimum length is 2!";
+    handleError( StkError::WARNING ); return;
+  }
+  else if ( lenX > MAX_SIZE ) {
+    oStream_ << "FastMesh2D::setNX(" << lenX << "): Maximum length is " << MAX_SIZE << '!';
+    handleError( StkError::WARNING ); return;
+  }
+
+  NX_ = lenX;
+}
+
+void FastMesh2D :: setNY( unsigned short lenY )
+{
+  if ( lenY < 2 ) {
+    oStream_ << "FastMesh2D::setNY(" << lenY << "): Minimum length is 2!";
+    handleError( StkError::WARNING ); return;
+  }
+  else if ( lenY > MAX_SIZE ) {
+    oStream_ << "FastMesh2D::setNY(" << lenY << "): Maximum length is " << MAX_SIZE << '!';
+    handleError( StkError::WARNING ); return;
+  }
+
+  NY_ = lenY;
+
+  // The rows in memory hold the last junction's waves too.
+  unsigned int stride = ( lenY + LINE_SIZE - 1 ) / LINE_SIZE * LINE_SIZE;
+  if ( stride != stride_ ) {
+    stride_ = stride;
+    this->clearMesh();
+  }
+}
+
+void FastMesh2D :: setDecay( StkFloat decayFactor )
+{
+  if ( decayFactor < 0.0 || decayFactor > 1.0 ) {
+    oStream_ << "FastMesh2D::setDecay: decayFactor is out of range!";
+    handleError( StkError::WARNING ); return;
+  }
+
+  gain_ = decayFactor;
+}
+
+void FastMesh2D :: setInputPosition( StkFloat xFactor, StkFloat yFactor )
+{
+  if ( xFactor < 0.0 || xFactor > 1.0 ) {
+    oStream_ << "FastMesh2D::setInputPosition xFactor value is out of range!";
+    handleError( StkError::WARNING ); return;
+  }
+
+  if ( yFactor < 0.0 || yFactor > 1.0 ) {
+    oStream_ << "FastMesh2D::setInputPosition yFactor value is out of range!";
+    handleError( StkError::WARNING ); return;
+  }
+
+  xInput_ = (unsigned short) (xFactor * (NX_ - 1));
+  yInput_ = (unsigned short) (yFactor * (NY_ - 1));
+}
+
+void FastMesh2D :: noteOn( StkFloat frequency, StkFloat amplitude )
+{
+  wave( 0, xInput_, XP )[yInput_] += amplitude;
+  wave( 0, xInput_, YP )[yInput_] += amplitude;
+}
+
+void FastMesh2D :: noteOff( StkFloat amplitude )
+{
+  return;
+}
+
+StkFloat FastMesh2D :: inputTick( StkFloat input )
+{
+  wave( 0, xInput_, XP )[yInput_] += input;
+  wave( 0, xInput_, YP )[yInput_] += input;
+
+  lastFrame_[0] = process();
+  return lastFrame_[0];
+}
+
+void FastMesh2D :: controlChange( int number, StkFloat value )
+{
+#if defined(_STK_DEBUG_)
+  if ( Stk::inRange( value, 0.0, 128.0 ) == false ) {
+    oStream_ << "FastMesh2D::controlChange: value (" << value << ") is out of range!";
+    handleError( StkError::WARNING ); return;
+  }
+#endif
+
+  StkFloat normalizedValue = value * ONE_OVER_128;
+  if ( number == 2 ) // 2
+    this->setNX( (unsigned short) (normalizedValue * (MAX_SIZE-2) + 2) );
+  else if ( number == 4 ) // 4
+    this->setNY( (unsigned short) (normalizedValue * (MAX_SIZE-2) + 2) );
+  else if ( number == 11 ) // 11
+    this->setDecay( 0.9 + (normalizedValue * 0.1) );
+  else if ( number == __SK_ModWheel_ ) // 1
+    this->setInputPosition( normalizedValue, normalizedValue );
+#if defined(_STK_DEBUG_)
+  else {
+    oStream_ << "FastMesh2D::controlChange: undefined control number (" << number << ")!";
+    handleError( StkError::WARNING );
+  }
+#endif
+}
+
+} // stk namespace
@@ -0,0 +1,214 @@
+#ifndef STK_FASTMESH2D_H
+#define STK_FASTMESH2D_H
+
+#include "Instrmnt.h"
+#include "VectorOps.h"
+
+namespace stk {
+
+/***************************************************/
+/*! \class FastMesh2D
+    \brief Vectorised two-dimensional rectilinear waveguide mesh class.
+
+    This class implements the same rectilinear, two-dimensional
+    digital waveguide mesh as the Mesh2D class, with the same
+    interface, but for meshes of up to 64 x 64 junctions (set at run
+    time), and much faster.
+
+    The four wave variables of each row of the mesh are stored next to
+    each other, in rows padded to whole cache lines, so that updating
+    a row of junctions reads and writes a few neighbouring lines.
+    Each row is updated by one vectorised kernel (see vectorops), and
+    the two sets of wave variables are swapped by pointer, rather than
+    by alternating tick functions.  The one-pole boundary filters
+    share their coefficients, with their states held in arrays.
+
+    Memory for the largest mesh is allocated on construction, so the
+    dimensions can be changed while running.  The mesh is cleared if
+    the y dimension changes the length of its rows in memory.
+
+    This is a digital waveguide model, making its
+    use possibly subject to patents held by Stanford
+    University, Yamaha, and others.
+
+    Control Change Numbers:
+       - X Dimension = 2
+       - Y Dimension = 4
+       - Mesh Decay = 11
+       - X-Y Input Position = 1
+
+    Based on the STK Mesh2D class, by Perry R. Cook and Gary P.
+    Scavone, 1995-2012 (not part of the STK distribution).
+*/
+/***************************************************/
+
+class FastMesh2D : public Instrmnt
+{
+ public:
+  //! The largest mesh dimension, in samples.
+  enum { MAX_SIZE = 64 };
+
+  //! Class constructor, taking the x and y dimensions in samples.
+  FastMesh2D( unsigned short nX, unsigned short nY );
+
+  //! Class destructor.
+  ~FastMesh2D( void );
+
+  //! Reset and clear all internal state.
+  void clear( void );
+
+  //! Set the x dimension size in samples (2 - 64).
+  void setNX( unsigned short lenX );
+
+  //! Set the y dimension size in samples (2 - 64).
+  void setNY( unsigned short lenY );
+
+  //! Return the x dimension size in samples.
+  unsigned short getNX( void ) const { return NX_; };
+
+  //! Return the y dimension size in samples.
+  unsigned short getNY( void ) const { return NY_; };
+
+  //! Set the x, y input position on a 0.0 - 1.0 scale.
+  void setInputPosition( StkFloat xFactor, StkFloat yFactor );
+
+  //! Set the loss filters gains (0.0 - 1.0).
+  void setDecay( StkFloat decayFactor );
+
+  //! Impulse the mesh with the given amplitude (frequency ignored).
+  void noteOn( StkFloat frequency, StkFloat amplitude );
+
+  //! Stop a note with the given amplitude (speed of decay) ... currently ignored.
+  void noteOff( StkFloat amplitude );
+
+  //! Calculate and return the signal energy stored in the mesh.
+  StkFloat energy( void );
+
+  //! Input a sample to the mesh and compute one output sample.
+  StkFloat inputTick( StkFloat input );
+
+  //! Perform the control change specified by \e number and \e value (0.0 - 128.0).
+  void controlChange( int number, StkFloat value );
+
+  //! Compute and return one output sample.
+  StkFloat tick( unsigned int channel = 0 );
+
+  //! Fill a channel of the StkFrames object with computed outputs.
+  /*!
+    The \c channel argument must be less than the number of
+    channels in the StkFrames argument (the first channel is specified
+    by 0).  However, range checking is only performed if _STK_DEBUG_
+    is defined during compilation, in which case an out-of-range value
+    will trigger an StkError exception.
+  */
+  StkFrames& tick( StkFrames& frames, unsigned int channel = 0 );
+
+  //! Fill an array with \c nFrames computed outputs.
+  void tick( StkFloat *output, unsigned int nFrames );
+
+ protected:
+
+  // The wave variables of each row, in this order.
+  enum { XP, XM, YP, YM, WAVES };
+
+  StkFloat process( void );
+  void clearMesh( void );
+
+  // The start of a row of one wave variable, in the current (0) or next (1) set.
+  StkFloat *wave( int set, unsigned int x, int variable ) { return rows_[set] + ( x * WAVES + variable ) * stride_; };
+
+  unsigned short NX_, NY_;
+  unsigned short xInput_, yInput_;
+  unsigned int stride_;              // the length of a row in memory (in samples)
+
+  std::vector<StkFloat> storage_;
+  StkFloat *rows_[2];                // the current and next wave variables (cache-line aligned)
+
+  // The boundary filters (one-pole, as in Mesh2D).
+  StkFloat b0_, a1_, gain_;
+  StkFloat filterX_[MAX_SIZE];
+  StkFloat filterY_[MAX_SIZE];
+};
+
+inline StkFloat FastMesh2D :: process( void )
+{
+  StkFloat *xp = wave( 0, 0, XP );
+  StkFloat *nxp = wave( 1, 0, XP );
+  const unsigned int row = WAVES * stride_;
+  const unsigned int nx = NX_, ny = NY_;
+  unsigned int x, y;
+
+  // Update the junctions a row at a time, scattering the outgoing
+  // waves into the next set of wave variables.
+  for ( x=0; x<nx-1; x++ ) {
+    StkFloat *in = xp + x * row, *out = nxp + x * row;
+    vectorops::meshJunctions( in + XP * stride_, in + row + XM * stride_, in + YP * stride_, in + YM * stride_ + 1,
+                              out + row + XP * stride_, out + XM * stride_, out + YP * stride_ + 1, out + YM * stride_,
+                              ny - 1 );
+  }
+
+  // Update the edge reflections, with filtering on one x and one y edge (as Mesh2D).
+  StkFloat *xm0 = wave( 0, 0, XM ), *nxp0 = wave( 1, 0, XP );
+  StkFloat *xpN = wave( 0, nx-1, XP ), *nxmN = wave( 1, nx-1, XM );
+  for ( y=0; y<ny-1; y++ ) {
+    filterY_[y] = b0_ * ( gain_ * xm0[y] ) - a1_ * filterY_[y];
+    nxp0[y] = filterY_[y];
+    nxmN[y] = xpN[y];
+  }
+  for ( x=0; x<nx-1; x++ ) {
+    filterX_[x] = b0_ * ( gain_ * wave( 0, x, YM )[0] ) - a1_ * filterX_[x];
+    wave( 1, x, YP )[0] = filterX_[x];
+    wave( 1, x, YM )[ny-1] = wave( 0, x, YP )[ny-1];
+  }
+
+  // Output = sum of outgoing waves at far corner (see Mesh2D).
+  StkFloat output = wave( 0, nx-1, XP )[ny-2] + wave( 0, nx-2, YP )[ny-1];
+
+  std::swap( rows_[0], rows_[1] );
+  return output;
+}
+
+inline StkFloat FastMesh2D :: tick( unsigned int )
+{
+  lastFrame_[0] = process();
+  return lastFrame_[0];
+}
+
+inline void FastMesh2D :: tick( StkFloat *output, unsigned int nFrames )
+{
+  for ( unsigned int i=0; i<nFrames; i++ )
+    output[i] = process();
+
+  if ( nFrames > 0 ) lastFrame_[0] = output[nFrames-1];
+}
+
+inline StkFrames& FastMesh2D :: tick( StkFrames& frames, unsigned int channel )
+{
+  unsigned int nChannels = lastFrame_.channels();
+#if defined(_STK_DEBUG_)
+  if ( channel > frames.channels() - nChannels ) {
+    oStream_ << "FastMesh2D::tick(): channel and StkFrames arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  StkFloat *samples = &frames[channel];
+  unsigned int j, hop = frames.channels() - nChannels;
+  if ( nChannels == 1 ) {
+    for ( unsigned int i=0; i<frames.frames(); i++, samples += hop )
+      *samples++ = tick();
+  }
+  else {
+    for ( unsigned int i=0; i<frames.frames(); i++, samples += hop ) {
+      *samples++ = tick();
+      for ( j=1; j<nChannels; j++ )
+        *samples++ = lastFrame_[j];
+    }
+  }
+
+  return frames;
+}
+
+} // stk namespace
+
+#endif
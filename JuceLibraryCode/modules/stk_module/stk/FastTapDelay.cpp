@@ -0,0 +1,112 @@
+/***************************************************/
+/*! \class FastTapDelay
+    \brief STK vectorised, linearly interpolating tapped delay line class.
+
+    This class implements a delay-line with an arbitrary number of
+    output "taps", each of which may have a fractional delay (read
+    with linear interpolation, as in DelayL).  With a single tap, it
+    can be used in place of DelayL, and with whole-sample delays, in
+    place of TapDelay.
+
+    The delay-line is a ring buffer which is written twice (its second
+    half mirrors the first), so that any stretch of it can be read
+    without wrapping around.  Blocks of input (from StkFrames or
+    arrays) are written all at once, and each tap's output is then
+    read as one contiguous run, with no per-sample index arithmetic or
+    branches, using AVX or SSE where available (see vectorops).
+
+    If the maximum length and tap delays are not specified during
+    instantiation, a fixed maximum length of 4095 and a single tap
+    delay of zero is set.
+
+    Based on the STK DelayL and TapDelay classes, by Perry R. Cook
+    and Gary P. Scavone, 1995-2012 (not part of the STK distribution).
+*/
+/***************************************************/
+
+#include "FastTapDelay.h"
+
+namespace stk {
+
+FastTapDelay :: FastTapDelay( std::vector<StkFloat> taps, unsigned long maxDelay )
+  : maxDelay_( 0 ), length_( 0 ), inPoint_( 0 )
+{
+  if ( maxDelay < 1 ) {
+    oStream_ << "FastTapDelay::FastTapDelay: maxDelay must be > 0!\n";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+
+  for ( unsigned int i=0; i<taps.size(); i++ ) {
+    if ( taps[i] < 0.0 || taps[i] > maxDelay ) {
+      oStream_ << "FastTapDelay::FastTapDelay: tap delay values must be from 0 to maxDelay!\n";
+      handleError( StkError::FUNCTION_ARGUMENT );
+    }
+  }
+
+  maxDelay_ = maxDelay;
+  this->resize();
+  chunk_.resize( CHUNK_SIZE, 0.0 );
+  this->setTapDelays( taps );
+}
+
+FastTapDelay :: ~FastTapDelay()
+{
+}
+
+void FastTapDelay :: resize( void )
+{
+  // The ring must keep the oldest input a tap can read (including
+  // the one it interpolates with) while a whole chunk is written.
+  length_ = maxDelay_ + CHUNK_SIZE + 1;
+  ring_.resize( 2 * length_ );
+  this->clear();
+}
+
+void FastTapDelay :: clear( void )
+{
+  for ( unsigned int i=0; i<ring_.size(); i++ )
+    ring_[i] = 0.0;
+  for ( unsigned int i=0; i<lastFrame_.size(); i++ )
+    lastFrame_[i] = 0.0;
+  inPoint_ = 0;
+}
+
+void FastTapDelay :: setMaximumDelay( unsigned long delay )
+{
+  if ( delay <= maxDelay_ ) return;
+
+  maxDelay_ = delay;
+  this->resize();
+}
+
+void FastTapDelay :: setTapDelays( std::vector<StkFloat> taps )
+{
+  for ( unsigned int i=0; i<taps.size(); i++ ) {
+    if ( taps[i] < 0.0 || taps[i] > maxDelay_ ) {
+      oStream_ << "FastTapDelay::setTapDelays: argument (" << taps[i] << ") out of range!\n";
+      handleError( StkError::WARNING ); return;
+    }
+  }
+
+  if ( taps.size() != delays_.size() )
+    lastFrame_.resize( 1, taps.size(), 0.0 );
+
+  delays_ = taps;
+}
+
+void FastTapDelay :: setDelay( StkFloat delay, unsigned int tap )
+{
+  if ( tap >= delays_.size() ) {
+    oStream_ << "FastTapDelay::setDelay: tap argument (" << tap << ") greater than the number of taps!\n";
+    handleError( StkError::WARNING ); return;
+  }
+
+  if ( delay < 0.0 || delay > maxDelay_ ) {
+    oStream_ << "FastTapDelay::setDelay: argument (" << delay << ") out of range!\n";
+    handleError( StkError::WARNING ); return;
+  }
+
+  delays_[tap] = delay;
+}
+
+} // stk namespace
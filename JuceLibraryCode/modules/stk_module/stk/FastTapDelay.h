@@ -0,0 +1,317 @@
+#ifndef STK_FASTTAPDELAY_H
+#define STK_FASTTAPDELAY_H
+
+#include "Filter.h"
+#include "VectorOps.h"
+
+namespace stk {
+
+/***************************************************/
+/*! \class FastTapDelay
+    \brief STK vectorised, linearly interpolating tapped delay line class.
+
+    This class implements a delay-line with an arbitrary number of
+    output "taps", each of which may have a fractional delay (read
+    with linear interpolation, as in DelayL).  With a single tap, it
+    can be used in place of DelayL, and with whole-sample delays, in
+    place of TapDelay.
+
+    The delay-line is a ring buffer which is written twice (its second
+    half mirrors the first), so that any stretch of it can be read
+    without wrapping around.  Blocks of input (from StkFrames or
+    arrays) are written all at once, and each tap's output is then
+    read as one contiguous run, with no per-sample index arithmetic or
+    branches, using AVX or SSE where available (see vectorops).
+
+    If the maximum length and tap delays are not specified during
+    instantiation, a fixed maximum length of 4095 and a single tap
+    delay of zero is set.
+
+    Based on the STK DelayL and TapDelay classes, by Perry R. Cook
+    and Gary P. Scavone, 1995-2012 (not part of the STK distribution).
+*/
+/***************************************************/
+
+class FastTapDelay : public Filter
+{
+ public:
+
+  //! The default constructor creates a delay-line with maximum length of 4095 samples and a single tap at delay = 0.
+  /*!
+    An StkError will be thrown if any tap delay parameter is less
+    than zero, the maximum delay parameter is less than one, or any
+    tap delay parameter is greater than the maxDelay value.
+   */
+  FastTapDelay( std::vector<StkFloat> taps = std::vector<StkFloat>( 1, 0.0 ), unsigned long maxDelay = 4095 );
+
+  //! Class destructor.
+  ~FastTapDelay();
+
+  //! Clears all internal states of the delay line.
+  void clear( void );
+
+  //! Set the maximum delay-line length.
+  /*!
+    This method should generally only be used during initial setup
+    of the delay line, as it clears the delay line if it grows.  If
+    the current maximum length is greater than the new length, no
+    change will be made.
+  */
+  void setMaximumDelay( unsigned long delay );
+
+  //! Return the maximum delay-line length.
+  unsigned long getMaximumDelay( void ) const { return maxDelay_; };
+
+  //! Set the delay-line tap lengths.
+  /*!
+    The valid range for each tap length is from 0 to the maximum delay-line length.
+  */
+  void setTapDelays( std::vector<StkFloat> taps );
+
+  //! Return the delay-line tap lengths.
+  std::vector<StkFloat> getTapDelays( void ) const { return delays_; };
+
+  //! Set the delay of one tap (the first, by default, as for DelayL::setDelay()).
+  void setDelay( StkFloat delay, unsigned int tap = 0 );
+
+  //! Return the delay of one tap (the first, by default).
+  StkFloat getDelay( unsigned int tap = 0 ) const { return delays_[tap]; };
+
+  //! Return the value at \e tapDelay samples from the delay-line input (0 is the last input).
+  StkFloat tapOut( unsigned long tapDelay ) const;
+
+  //! Set the \e value at \e tapDelay samples from the delay-line input (0 is the last input).
+  void tapIn( StkFloat value, unsigned long tapDelay );
+
+  //! Sum the provided \e value into the delay line at \e tapDelay samples from the input, returning the sum.
+  StkFloat addTo( StkFloat value, unsigned long tapDelay );
+
+  //! Return the value which will be output by the first tap on the next call to tick().
+  /*!
+    This method is valid only for delay settings greater than zero!
+   */
+  StkFloat nextOut( void ) const;
+
+  //! Return the specified tap value of the last computed frame.
+  StkFloat lastOut( unsigned int tap = 0 ) const { return lastFrame_[tap]; };
+
+  //! Input one sample to the delayline and return the output of the first tap.
+  StkFloat tick( StkFloat input );
+
+  //! Input one sample to the delayline and return outputs at all tap positions.
+  /*!
+    The StkFrames argument reference is returned.  The output
+    values are ordered according to the tap positions set using the
+    setTapDelays() function (no sorting is performed).  The StkFrames
+    argument must contain at least as many channels as the number of
+    taps.  However, range checking is only performed if _STK_DEBUG_ is
+    defined during compilation, in which case an out-of-range value
+    will trigger an StkError exception.
+  */
+  StkFrames& tick( StkFloat input, StkFrames& outputs );
+
+  //! Take a channel of the StkFrames object as inputs to the delayline and write the outputs of the taps back to the same object.
+  /*!
+    The StkFrames argument reference is returned.  The outputs of
+    the taps are written to consecutive channels, starting with \c
+    channel (so with one tap, the input channel is replaced with the
+    output, as in DelayL).  The StkFrames argument must contain
+    enough channels for all the taps.  However, range checking is
+    only performed if _STK_DEBUG_ is defined during compilation, in
+    which case an out-of-range value will trigger an StkError
+    exception.
+  */
+  StkFrames& tick( StkFrames& frames, unsigned int channel = 0 );
+
+  //! Take a channel of the \c iFrames object as inputs to the delayline and write the outputs of the taps to the \c oFrames object.
+  /*!
+    The \c iFrames object reference is returned.  The outputs of the
+    taps are written to consecutive channels of \c oFrames, starting
+    with \c oChannel.  However, range checking is only performed if
+    _STK_DEBUG_ is defined during compilation, in which case an
+    out-of-range value will trigger an StkError exception.
+  */
+  StkFrames& tick( StkFrames& iFrames, StkFrames &oFrames, unsigned int iChannel = 0, unsigned int oChannel = 0 );
+
+  //! Input \c nFrames samples, and write the output of each tap to its own array in \c outputs.
+  /*!
+    The output arrays may include the input array (e.g. for a single
+    tap, processed in place).
+  */
+  void tick( const StkFloat *input, StkFloat **outputs, unsigned int nFrames );
+
+ protected:
+
+  // Blocks are processed in chunks of up to this many frames.
+  enum { CHUNK_SIZE = 256 };
+
+  void resize( void );
+  void write( const StkFloat *input, unsigned int iHop, unsigned int nFrames );
+  void read( unsigned int tap, StkFloat *output, unsigned int nFrames ) const;
+
+  unsigned long maxDelay_;
+  unsigned long length_;        // the ring's length (it holds twice this)
+  unsigned long inPoint_;       // where the next input is written (less than length_)
+  std::vector<StkFloat> ring_;
+  std::vector<StkFloat> delays_;
+  std::vector<StkFloat> chunk_; // the input (and outputs) of a chunk, for StkFrames
+
+};
+
+inline StkFloat FastTapDelay :: tapOut( unsigned long tapDelay ) const
+{
+  // (always within the ring, as tapDelay <= maxDelay_ < length_)
+  return ring_[inPoint_ + length_ - 1 - tapDelay];
+}
+
+inline void FastTapDelay :: tapIn( StkFloat value, unsigned long tapDelay )
+{
+  // Both copies of the sample, in the ring and its mirror.
+  unsigned long tap = ( inPoint_ + length_ - 1 - tapDelay ) % length_;
+  ring_[tap] = ring_[tap + length_] = value;
+}
+
+inline StkFloat FastTapDelay :: addTo( StkFloat value, unsigned long tapDelay )
+{
+  unsigned long tap = ( inPoint_ + length_ - 1 - tapDelay ) % length_;
+  return ring_[tap] = ring_[tap + length_] = ring_[tap] + value;
+}
+
+inline StkFloat FastTapDelay :: nextOut( void ) const
+{
+  // After the next input, x[n-whole] will be one sample further from
+  // the input than it is now (so x[n-whole+1] is now at whole - 1).
+  unsigned long whole = (unsigned long) delays_[0];
+  StkFloat alpha = delays_[0] - whole;
+  const StkFloat *x = &ring_[inPoint_ + length_ - whole];
+
+  return x[0] * ( 1.0 - alpha ) + x[-1] * alpha;
+}
+
+inline void FastTapDelay :: write( const StkFloat *input, unsigned int iHop, unsigned int nFrames )
+{
+  while ( nFrames > 0 ) {
+    // Up to the end of the ring, then from the start.
+    unsigned int count = length_ - inPoint_ < nFrames ? (unsigned int) ( length_ - inPoint_ ) : nFrames;
+    StkFloat *lower = &ring_[inPoint_];
+    StkFloat *upper = lower + length_;
+
+    if ( iHop == 1 ) {
+      vectorops::multiply( lower, input, gain_, count );
+    }
+    else {
+      for ( unsigned int i=0; i<count; i++ )
+        lower[i] = input[i * iHop] * gain_;
+    }
+    for ( unsigned int i=0; i<count; i++ )
+      upper[i] = lower[i];
+
+    inPoint_ += count;
+    if ( inPoint_ == length_ ) inPoint_ = 0;
+    input += count * iHop;
+    nFrames -= count;
+  }
+}
+
+inline void FastTapDelay :: read( unsigned int tap, StkFloat *output, unsigned int nFrames ) const
+{
+  // Reads the last nFrames inputs, delayed.  The first is x[n-delay],
+  // interpolated between x[n-whole] and x[n-whole-1], which are at
+  // start and start-1 (both inside the ring, as start is from 1 to length_).
+  unsigned long whole = (unsigned long) delays_[tap];
+  StkFloat alpha = delays_[tap] - whole;
+  unsigned long start = ( inPoint_ + 2 * length_ - nFrames - whole - 1 ) % length_ + 1;
+
+  vectorops::multiply( output, &ring_[start], (StkFloat) ( 1.0 - alpha ), nFrames );
+  if ( alpha != 0.0 )
+    vectorops::multiplyAdd( output, &ring_[start - 1], alpha, nFrames );
+}
+
+inline StkFloat FastTapDelay :: tick( StkFloat input )
+{
+  this->write( &input, 1, 1 );
+  for ( unsigned int i=0; i<delays_.size(); i++ )
+    this->read( i, &lastFrame_[i], 1 );
+
+  return lastFrame_[0];
+}
+
+inline StkFrames& FastTapDelay :: tick( StkFloat input, StkFrames& outputs )
+{
+#if defined(_STK_DEBUG_)
+  if ( outputs.channels() < delays_.size() ) {
+    oStream_ << "FastTapDelay::tick(): number of taps > channels in StkFrames argument!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  this->write( &input, 1, 1 );
+  for ( unsigned int i=0; i<delays_.size(); i++ ) {
+    this->read( i, &outputs[i], 1 );
+    lastFrame_[i] = outputs[i];
+  }
+
+  return outputs;
+}
+
+inline void FastTapDelay :: tick( const StkFloat *input, StkFloat **outputs, unsigned int nFrames )
+{
+  for ( unsigned int start=0; start<nFrames; start+=CHUNK_SIZE ) {
+    unsigned int count = nFrames - start < (unsigned int) CHUNK_SIZE ? nFrames - start : (unsigned int) CHUNK_SIZE;
+
+    // The whole chunk is written before it's read, so the
+    // outputs may overwrite the input.
+    this->write( input + start, 1, count );
+    for ( unsigned int i=0; i<delays_.size(); i++ )
+      this->read( i, outputs[i] + start, count );
+  }
+
+  if ( nFrames > 0 )
+    for ( unsigned int i=0; i<delays_.size(); i++ )
+      lastFrame_[i] = outputs[i][nFrames-1];
+}
+
+inline StkFrames& FastTapDelay :: tick( StkFrames& frames, unsigned int channel )
+{
+  return tick( frames, frames, channel, channel );
+}
+
+inline StkFrames& FastTapDelay :: tick( StkFrames& iFrames, StkFrames& oFrames, unsigned int iChannel, unsigned int oChannel )
+{
+#if defined(_STK_DEBUG_)
+  if ( iChannel >= iFrames.channels() ) {
+    oStream_ << "FastTapDelay::tick(): channel and StkFrames arguments are incompatible!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+  if ( oChannel + delays_.size() > oFrames.channels() ) {
+    oStream_ << "FastTapDelay::tick(): number of taps > channels in output StkFrames argument!";
+    handleError( StkError::FUNCTION_ARGUMENT );
+  }
+#endif
+
+  unsigned int iHop = iFrames.channels(), oHop = oFrames.channels();
+  StkFloat *chunk = &chunk_[0];
+
+  for ( unsigned int start=0; start<iFrames.frames(); start+=CHUNK_SIZE ) {
+    unsigned int count = iFrames.frames() - start < (unsigned int) CHUNK_SIZE ? iFrames.frames() - start : (unsigned int) CHUNK_SIZE;
+
+    this->write( &iFrames[start * iHop + iChannel], iHop, count );
+    for ( unsigned int i=0; i<delays_.size(); i++ ) {
+      this->read( i, chunk, count );
+
+      StkFloat *oSamples = &oFrames[start * oHop + oChannel + i];
+      for ( unsigned int j=0; j<count; j++, oSamples += oHop )
+        *oSamples = chunk[j];
+    }
+  }
+
+  if ( iFrames.frames() > 0 )
+    for ( unsigned int i=0; i<delays_.size(); i++ )
+      lastFrame_[i] = oFrames( iFrames.frames() - 1, oChannel + i );
+
+  return iFrames;
+}
+
+} // stk namespace
+
+#endif
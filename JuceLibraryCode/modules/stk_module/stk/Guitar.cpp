@@ -49,6 +49,7 @@ Guitar :: Guitar( unsigned int nStrings, std::string bodyfile )
   setBodyFile( bodyfile );
 
   couplingGain_ = BASE_COUPLING_GAIN;
+  decaySamples_ = (unsigned int) floor( 0.1 * Stk::sampleRate() );
   couplingFilter_.setPole( 0.9 );
   pickFilter_.setPole( 0.95 );
   lastFrame_.resize(1, 1, 0.0);
@@ -183,6 +184,7 @@ void Guitar :: noteOn( StkFloat frequency, StkFloat amplitude, unsigned int stri
   }
 #endif
 
+  decaySamples_ = (unsigned int) floor( 0.1 * Stk::sampleRate() );
   this->setFrequency( frequency, string );
   stringState_[string] = 2;
   filePointer_[string] = 0;
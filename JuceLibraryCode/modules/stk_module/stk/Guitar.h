@@ -122,6 +122,7 @@ class Guitar : public Stk
   std::vector< stk::Twang > strings_;
   std::vector< int > stringState_; // 0 = off, 1 = decaying, 2 = on
   std::vector< unsigned int > decayCounter_;
+  unsigned int decaySamples_; // 0.1 seconds, at the sample rate of the last noteOn()
   std::vector< unsigned int > filePointer_;
   std::vector< StkFloat > pluckGains_;
 
@@ -148,7 +149,7 @@ inline StkFloat Guitar :: tick( StkFloat input )
       if ( stringState_[i] == 1 ) {
         if ( fabs( strings_[i].lastOut() ) < 0.001 ) decayCounter_[i]++;
         else decayCounter_[i] = 0;
-        if ( decayCounter_[i] > (unsigned int) floor( 0.1 * Stk::sampleRate() ) ) {
+        if ( decayCounter_[i] > decaySamples_ ) {
           stringState_[i] = 0;
           decayCounter_[i] = 0;
         }
@@ -14,7 +14,8 @@
 namespace stk {
 
 LentPitShift::LentPitShift( StkFloat periodRatio, int tMax )
-  : inputFrames(0.,tMax,1), outputFrames(0.,tMax,1), ptrFrames(0), inputPtr(0), outputPtr(0.), tMax_(tMax), periodRatio_(periodRatio), zeroFrame(0., tMax, 1)
+  : inputFrames(0.,tMax,1), outputFrames(0.,tMax,1), ptrFrames(0), inputPtr(0), history_(0., 2*tMax, 1), fastTracking_(true),
+    outputPtr(0.), tMax_(tMax), periodRatio_(periodRatio), zeroFrame(0., tMax, 1)
 {
 	window = new StkFloat[2*tMax_]; // Allocation of the array for the hamming window
 	threshold_ = 0.1;               // Default threshold for pitch tracking
@@ -41,6 +42,8 @@ void LentPitShift :: clear()
 {
 	inputLine_.clear();
 	outputLine_.clear();
+	for ( unsigned int i=0; i<history_.size(); i++ )
+		history_[i] = 0.;
 }
 
 void LentPitShift :: setShift( StkFloat shift )
@@ -3,6 +3,7 @@
 
 #include "Effect.h"
 #include "Delay.h"
+#include "VectorOps.h"
 
 namespace stk {
 
@@ -13,6 +14,11 @@ namespace stk {
     This class implements a pitch shifter using pitch 
     tracking and sample windowing and shifting.
 
+    By default, the pitch tracker's difference function is computed
+    from running sums of the signal energy and vectorised correlations
+    over a contiguous copy of the input, rather than by reading every
+    lag from the input delay line (see setFastTracking()).
+
     by Francois Germain, 2009.
 */
 /***************************************************/
@@ -24,10 +30,10 @@ class LentPitShift : public Effect
   LentPitShift( StkFloat periodRatio = 1.0, int tMax = RT_BUFFER_SIZE );
 
   ~LentPitShift( void ) {
-    delete window;
-    delete dt;
-    delete dpt;
-    delete cumDt;
+    delete [] window;
+    delete [] dt;
+    delete [] dpt;
+    delete [] cumDt;
   }
 
   //! Reset and clear all internal state.
@@ -36,6 +42,17 @@ class LentPitShift : public Effect
   //! Set the pitch shift factor (1.0 produces no shift).
   void setShift( StkFloat shift );
 
+  //! Choose how the pitch tracker's difference function is computed.
+  /*!
+    The fast method (the default) expands each squared difference into
+    the energies of the two windows, which are updated incrementally
+    from one lag to the next, less twice their correlation, computed as
+    a dot product over contiguous memory.  It costs a fraction of the
+    original method, which reads each lag from the input delay line,
+    and gives the same result up to rounding.
+  */
+  void setFastTracking( bool fast ) { fastTracking_ = fast; };
+
   //! Input one sample to the filter and return one output.
   StkFloat tick( StkFloat input );
 
@@ -70,6 +87,10 @@ class LentPitShift : public Effect
   */
   void process( );
 
+  //! Calculate the difference function dt for the frame in inputFrames.
+  void difference( void );
+  void fastDifference( void );
+
   // Frame storage vectors for process function
   StkFrames inputFrames;
   StkFrames outputFrames;
@@ -79,6 +100,10 @@ class LentPitShift : public Effect
   Delay inputLine_;
   int inputPtr;
 
+  // The last two frames of input, contiguous (for the fast difference function)
+  StkFrames history_;
+  bool fastTracking_;
+
   // Output delay line
   Delay outputLine_;
   double outputPtr;
@@ -106,16 +131,12 @@ class LentPitShift : public Effect
 
 };
 
-inline void LentPitShift::process()
+inline void LentPitShift::difference()
 {
   StkFloat x_t;    // input coefficient
   StkFloat x_t_T;  // previous input coefficient at T samples
   StkFloat coeff;  // new coefficient for the difference function
 
-  int alternativePitch = tMax_;  // Global minimum storage
-  lastPeriod_ = tMax_+1;         // Storage of the lowest local minimum under the threshold
-
-  // Loop variables
   unsigned long delay_;
   unsigned int n;
 
@@ -126,7 +147,6 @@ inline void LentPitShift::process()
   for ( delay_=1; delay_<=tMax_; delay_++ )
     dt[delay_] = 0.;
 
-  // Calculation of the dt coefficients and update of the input delay line.
   for ( n=0; n<inputFrames.size(); n++ ) {
     x_t = inputLine_.tick( inputFrames[ n ] );
     for ( delay_=1; delay_<= tMax_; delay_++ ) {
@@ -135,6 +155,51 @@ inline void LentPitShift::process()
       dt[delay_] += coeff * coeff;
     }
   }
+}
+
+inline void LentPitShift::fastDifference()
+{
+  // The current frame follows the previous one in history_, so the
+  // samples up to tMax_ before each input are at negative offsets from x.
+  StkFloat *x = &history_[tMax_];
+  unsigned long size = inputFrames.size();
+  unsigned long delay_;
+
+  for ( unsigned long n=0; n<size; n++ )
+    x[n] = inputLine_.tick( inputFrames[n] );
+
+  // dt[T] = sum (x[n] - x[n-T])^2
+  //       = sum x[n]^2 + sum x[n-T]^2 - 2 sum x[n] x[n-T]
+  // where the energy of the delayed window changes by one sample in
+  // and one out from each T to the next.
+  double energy = vectorops::dotProduct( x, x, (unsigned int) size );
+  double delayedEnergy = energy;
+
+  for ( delay_=1; delay_<=tMax_; delay_++ ) {
+    delayedEnergy += x[-(long) delay_] * x[-(long) delay_] - x[size-delay_] * x[size-delay_];
+    StkFloat correlation = vectorops::dotProduct( x, x - delay_, (unsigned int) size );
+    StkFloat value = (StkFloat) ( energy + delayedEnergy - 2.0 * correlation );
+    dt[delay_] = value > 0.0 ? value : 0.0; // (rounding can take a perfect match below zero)
+  }
+
+  // Keep this frame for the next.
+  for ( unsigned long n=0; n<size; n++ )
+    history_[n] = x[n];
+}
+
+inline void LentPitShift::process()
+{
+  int alternativePitch = tMax_;  // Global minimum storage
+  lastPeriod_ = tMax_+1;         // Storage of the lowest local minimum under the threshold
+
+  // Loop variables
+  unsigned long delay_;
+
+  // Calculation of the dt coefficients and update of the input delay line.
+  if ( fastTracking_ )
+    fastDifference();
+  else
+    difference();
 
   // Calculation of the pitch tracking function and test for the minima.
   for ( delay_=1; delay_<=tMax_; delay_++ ) {
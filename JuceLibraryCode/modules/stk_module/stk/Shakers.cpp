@@ -252,6 +252,7 @@ const StkFloat LITTLEROCKS_GAINS[LITTLEROCKS_RESONANCES] = { 1.0 };
 Shakers :: Shakers( int type )
 {
   shakerType_ = -1;
+  radiansPerHertz_ = TWO_PI / Stk::sampleRate();
   this->setType( type );
 }
 
@@ -666,6 +667,7 @@ void Shakers :: noteOn( StkFloat frequency, StkFloat amplitude )
 {
   // Yep ... pretty kludgey, but it works!
   int noteNumber = (int) ((12 * log(frequency/220.0)/log(2.0)) + 57.01) % 32;
+  radiansPerHertz_ = TWO_PI / Stk::sampleRate();
   if ( shakerType_ != noteNumber ) this->setType( noteNumber );
 
   shakeEnergy_ += amplitude * MAX_SHAKE * 0.1;
@@ -145,6 +145,7 @@ class Shakers : public Instrmnt
   std::vector< bool > doVaryFrequency_;
   std::vector< StkFloat > tempFrequencies_;
   StkFloat varyFactor_;
+  StkFloat radiansPerHertz_; // TWO_PI / the sample rate of the last noteOn(), for tick()
 };
 
 inline void Shakers :: setResonance( BiQuad &filter, StkFloat frequency, StkFloat radius )
@@ -220,7 +221,7 @@ inline void Shakers :: waterDrop( void )
     filters_[i].gain *= baseRadii_[i];
     if ( filters_[i].gain > 0.001 ) {
       tempFrequencies_[i] *= WATER_FREQ_SWEEP;
-      filters_[i].a[1] = -2.0 * baseRadii_[i] * cos( TWO_PI * tempFrequencies_[i] / Stk::sampleRate() );
+      filters_[i].a[1] = -2.0 * baseRadii_[i] * cos( tempFrequencies_[i] * radiansPerHertz_ );
     }
     else
       filters_[i].gain = 0.0;
@@ -265,7 +266,7 @@ inline StkFloat Shakers :: tick( unsigned int )
         for ( unsigned int i=0; i<nResonances_; i++ ) {
           if ( doVaryFrequency_[i] ) {
             StkFloat tempRand = baseFrequencies_[i] * ( 1.0 + ( varyFactor_ * noise() ) );
-            filters_[i].a[1] = -2.0 * baseRadii_[i] * cos( TWO_PI * tempRand / Stk::sampleRate() );
+            filters_[i].a[1] = -2.0 * baseRadii_[i] * cos( tempRand * radiansPerHertz_ );
           }
         }
         if ( shakerType_ == 22 ) iTube = randomInt( 7 ); // ANGKLUNG_RESONANCES
@@ -53,6 +53,12 @@
 #include "Stk.h"
 #include <stdlib.h>
 
+#if defined(__OS_WINDOWS__) || defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <pthread.h>
+#endif
+
 namespace stk {
 
 StkFloat Stk :: srate_ = (StkFloat) SRATE;
@@ -66,6 +72,7 @@ const Stk::StkFormat Stk :: STK_FLOAT64 = 0x20;
 bool Stk :: showWarnings_ = true;
 bool Stk :: printErrors_ = true;
 std::vector<Stk *> Stk :: alertList_;
+std::vector<const StkFloat *> Stk :: alertRates_;
 std::ostringstream Stk :: oStream_;
 
 Stk :: Stk( void )
@@ -77,17 +84,93 @@ Stk :: ~Stk( void )
 {
 }
 
+// The per-thread sample rates (see setThreadSampleRate()), and a lock
+// for the alert list, which may be changed by objects created and
+// destroyed on different threads.
+namespace {
+
+#if defined(__OS_WINDOWS__) || defined(_WIN32)
+  struct ThreadRate
+  {
+    ThreadRate( void ) : index_( TlsAlloc() ) {}
+    const StkFloat *get( void ) const { return (const StkFloat *) TlsGetValue( index_ ); }
+    void set( const StkFloat *rate ) { TlsSetValue( index_, (LPVOID) rate ); }
+    DWORD index_;
+  };
+
+  struct AlertLock
+  {
+    AlertLock( void ) { InitializeCriticalSection( &section_ ); }
+    void enter( void ) { EnterCriticalSection( &section_ ); }
+    void exit( void ) { LeaveCriticalSection( &section_ ); }
+    CRITICAL_SECTION section_;
+  };
+#else
+  struct ThreadRate
+  {
+    ThreadRate( void ) { pthread_key_create( &key_, NULL ); }
+    const StkFloat *get( void ) const { return (const StkFloat *) pthread_getspecific( key_ ); }
+    void set( const StkFloat *rate ) { pthread_setspecific( key_, rate ); }
+    pthread_key_t key_;
+  };
+
+  struct AlertLock
+  {
+    AlertLock( void ) { pthread_mutex_init( &mutex_, NULL ); }
+    void enter( void ) { pthread_mutex_lock( &mutex_ ); }
+    void exit( void ) { pthread_mutex_unlock( &mutex_ ); }
+    pthread_mutex_t mutex_;
+  };
+#endif
+
+  // Created on first use, in case STK objects are created during static initialisation.
+  ThreadRate& threadRate( void ) { static ThreadRate rate; return rate; }
+  AlertLock& alertLock( void ) { static AlertLock lock; return lock; }
+
+  struct ScopedAlertLock
+  {
+    ScopedAlertLock( void ) { alertLock().enter(); }
+    ~ScopedAlertLock( void ) { alertLock().exit(); }
+  };
+
+} // namespace
+
+StkFloat Stk :: sampleRate( void )
+{
+  const StkFloat *rate = threadRate().get();
+  return rate ? *rate : srate_;
+}
+
+const StkFloat *Stk :: setThreadSampleRate( const StkFloat *rate )
+{
+  const StkFloat *previous = threadRate().get();
+  threadRate().set( rate );
+  return previous;
+}
+
 void Stk :: setSampleRate( StkFloat rate )
 {
   if ( rate > 0.0 && rate != srate_ ) {
     StkFloat oldRate = srate_;
     srate_ = rate;
 
+    ScopedAlertLock lock;
     for ( unsigned int i=0; i<alertList_.size(); i++ )
-      alertList_[i]->sampleRateChanged( srate_, oldRate );
+      if ( alertRates_[i] == NULL )
+        alertList_[i]->sampleRateChanged( srate_, oldRate );
   }
 }
 
+void Stk :: threadSampleRateChanged( const StkFloat *rate, StkFloat oldRate )
+{
+  if ( rate == NULL || *rate <= 0.0 || *rate == oldRate ) return;
+
+  ScopedAlertLock lock;
+  for ( unsigned int i=0; i<alertList_.size(); i++ )
+    if ( alertRates_[i] == rate )
+      alertList_[i]->sampleRateChanged( *rate, oldRate );
+}
+
 void Stk :: sampleRateChanged( StkFloat newRate, StkFloat oldRate )
 {
   // This function should be reimplemented in classes that need to
@@ -97,17 +180,21 @@ void Stk :: sampleRateChanged( StkFloat newRate, StkFloat oldRate )
 
 void Stk :: addSampleRateAlert( Stk *ptr )
 {
+  ScopedAlertLock lock;
   for ( unsigned int i=0; i<alertList_.size(); i++ )
     if ( alertList_[i] == ptr ) return;
 
   alertList_.push_back( ptr );
+  alertRates_.push_back( threadRate().get() );
 }
 
 void Stk :: removeSampleRateAlert( Stk *ptr )
 {
+  ScopedAlertLock lock;
   for ( unsigned int i=0; i<alertList_.size(); i++ ) {
     if ( alertList_[i] == ptr ) {
       alertList_.erase( alertList_.begin() + i );
+      alertRates_.erase( alertRates_.begin() + i );
       return;
     }
   }
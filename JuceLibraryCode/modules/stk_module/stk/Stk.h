@@ -141,7 +141,12 @@ public:
   static const StkFormat STK_FLOAT64; /*!< Normalized between plus/minus 1.0. */
 
   //! Static method that returns the current STK sample rate.
-  static StkFloat sampleRate( void ) { return srate_; }
+  /*!
+    If a rate has been set for the calling thread, using
+    setThreadSampleRate(), that rate is returned.  Otherwise, the
+    global rate is returned.
+  */
+  static StkFloat sampleRate( void );
 
   //! Static method that sets the STK sample rate.
   /*!
@@ -163,6 +168,31 @@ public:
   */
   static void setSampleRate( StkFloat rate );
 
+  //! Static method that sets the sample rate seen by STK classes used on the calling thread.
+  /*!
+    This allows several independent processors in the same process
+    (e.g. plugin instances) to use STK classes at different rates, and
+    on separate threads, without changing the global rate.  Unlike
+    setSampleRate(), no sample rate change notifications are sent
+    (see threadSampleRateChanged()).  The rate is read through the given pointer, which must remain
+    valid until it is replaced.  A NULL pointer restores the global
+    rate.  The previous pointer is returned, so that calls can be
+    nested.
+  */
+  static const StkFloat *setThreadSampleRate( const StkFloat *rate );
+
+  //! Static method that notifies the objects which use a thread sample rate that it has changed.
+  /*!
+    Objects that ask for sample rate change notification are
+    registered with the rate of the thread that creates them (see
+    setThreadSampleRate()).  When the rate that \e rate points to
+    changes (to the value it now holds), this method calls
+    sampleRateChanged() for the objects registered with it, and only
+    those.  Likewise, setSampleRate() only notifies the objects
+    registered with the global rate.
+  */
+  static void threadSampleRateChanged( const StkFloat *rate, StkFloat oldRate );
+
   //! A function to enable/disable the automatic updating of class data when the STK sample rate changes.
   /*!
     This function allows the user to enable or disable class data
@@ -214,6 +244,7 @@ private:
   static bool showWarnings_;
   static bool printErrors_;
   static std::vector<Stk *> alertList_;
+  static std::vector<const StkFloat *> alertRates_; // the thread rate each was registered with (or NULL)
 
 protected:
 
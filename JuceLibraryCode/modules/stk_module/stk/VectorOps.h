@@ -0,0 +1,204 @@
+#ifndef STK_VECTOROPS_H
+#define STK_VECTOROPS_H
+
+#include "Stk.h"
+
+#if defined(__AVX__)
+  #include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 1 )
+  #include <xmmintrin.h>
+  #define STK_USE_SSE
+#endif
+
+namespace stk {
+
+/***************************************************/
+/*! \namespace stk::vectorops
+    \brief Vectorised kernels for the block-processing classes.
+
+    These operate on contiguous arrays of samples, using AVX or SSE
+    when StkFloat is a float and the compiler targets them, and
+    plain loops otherwise.  Unaligned arrays are allowed.
+
+    Written for this STK module's block-processing classes (not
+    part of the STK distribution).
+*/
+/***************************************************/
+
+namespace vectorops {
+
+//! Return the sum of a[i] * b[i].
+template <typename T>
+inline T dotProduct( const T *a, const T *b, unsigned int n )
+{
+  T sum = 0.0;
+  for ( unsigned int i=0; i<n; i++ ) sum += a[i] * b[i];
+  return sum;
+}
+
+//! Set d[i] = s[i] * gain.
+template <typename T>
+inline void multiply( T *d, const T *s, T gain, unsigned int n )
+{
+  for ( unsigned int i=0; i<n; i++ ) d[i] = s[i] * gain;
+}
+
+//! Set d[i] += s[i] * gain.
+template <typename T>
+inline void multiplyAdd( T *d, const T *s, T gain, unsigned int n )
+{
+  for ( unsigned int i=0; i<n; i++ ) d[i] += s[i] * gain;
+}
+
+//! Scatter n junctions of a 2-D waveguide mesh (see FastMesh2D).
+/*!
+  Each junction's velocity is half the sum of its four incoming
+  waves, and each outgoing wave is that less the incoming wave from
+  the opposite direction: ox[i] = v - ixm[i], oxm[i] = v - ix[i],
+  oy[i] = v - iym[i] and oym[i] = v - iy[i].  (The incoming and
+  outgoing arrays must not overlap.)
+*/
+template <typename T>
+inline void meshJunctions( const T *ix, const T *ixm, const T *iy, const T *iym,
+                           T *ox, T *oxm, T *oy, T *oym, unsigned int n )
+{
+  for ( unsigned int i=0; i<n; i++ ) {
+    T v = ( ix[i] + ixm[i] + iy[i] + iym[i] ) * (T) 0.5;
+    ox[i] = v - ixm[i];
+    oxm[i] = v - ix[i];
+    oy[i] = v - iym[i];
+    oym[i] = v - iy[i];
+  }
+}
+
+#if defined(__AVX__)
+
+inline float dotProduct( const float *a, const float *b, unsigned int n )
+{
+  __m256 sum0 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps();
+  unsigned int i = 0;
+  for ( ; i+16<=n; i+=16 ) {
+    sum0 = _mm256_add_ps( sum0, _mm256_mul_ps( _mm256_loadu_ps( a+i ), _mm256_loadu_ps( b+i ) ) );
+    sum1 = _mm256_add_ps( sum1, _mm256_mul_ps( _mm256_loadu_ps( a+i+8 ), _mm256_loadu_ps( b+i+8 ) ) );
+  }
+  for ( ; i+8<=n; i+=8 )
+    sum0 = _mm256_add_ps( sum0, _mm256_mul_ps( _mm256_loadu_ps( a+i ), _mm256_loadu_ps( b+i ) ) );
+
+  sum0 = _mm256_add_ps( sum0, sum1 );
+  __m128 sum = _mm_add_ps( _mm256_castps256_ps128( sum0 ), _mm256_extractf128_ps( sum0, 1 ) );
+  sum = _mm_add_ps( sum, _mm_movehl_ps( sum, sum ) );
+  sum = _mm_add_ss( sum, _mm_shuffle_ps( sum, sum, 1 ) );
+
+  float result = _mm_cvtss_f32( sum );
+  for ( ; i<n; i++ ) result += a[i] * b[i];
+  return result;
+}
+
+inline void multiply( float *d, const float *s, float gain, unsigned int n )
+{
+  const __m256 g = _mm256_set1_ps( gain );
+  unsigned int i = 0;
+  for ( ; i+8<=n; i+=8 )
+    _mm256_storeu_ps( d+i, _mm256_mul_ps( _mm256_loadu_ps( s+i ), g ) );
+  for ( ; i<n; i++ ) d[i] = s[i] * gain;
+}
+
+inline void multiplyAdd( float *d, const float *s, float gain, unsigned int n )
+{
+  const __m256 g = _mm256_set1_ps( gain );
+  unsigned int i = 0;
+  for ( ; i+8<=n; i+=8 )
+    _mm256_storeu_ps( d+i, _mm256_add_ps( _mm256_loadu_ps( d+i ), _mm256_mul_ps( _mm256_loadu_ps( s+i ), g ) ) );
+  for ( ; i<n; i++ ) d[i] += s[i] * gain;
+}
+
+inline void meshJunctions( const float *ix, const float *ixm, const float *iy, const float *iym,
+                           float *ox, float *oxm, float *oy, float *oym, unsigned int n )
+{
+  const __m256 half = _mm256_set1_ps( 0.5f );
+  unsigned int i = 0;
+  for ( ; i+8<=n; i+=8 ) {
+    __m256 x = _mm256_loadu_ps( ix+i ), xm = _mm256_loadu_ps( ixm+i );
+    __m256 y = _mm256_loadu_ps( iy+i ), ym = _mm256_loadu_ps( iym+i );
+    __m256 v = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( x, xm ), y ), ym ), half );
+    _mm256_storeu_ps( ox+i, _mm256_sub_ps( v, xm ) );
+    _mm256_storeu_ps( oxm+i, _mm256_sub_ps( v, x ) );
+    _mm256_storeu_ps( oy+i, _mm256_sub_ps( v, ym ) );
+    _mm256_storeu_ps( oym+i, _mm256_sub_ps( v, y ) );
+  }
+  for ( ; i<n; i++ ) {
+    float v = ( ix[i] + ixm[i] + iy[i] + iym[i] ) * 0.5f;
+    ox[i] = v - ixm[i]; oxm[i] = v - ix[i];
+    oy[i] = v - iym[i]; oym[i] = v - iy[i];
+  }
+}
+
+#elif defined(STK_USE_SSE)
+
+inline float dotProduct( const float *a, const float *b, unsigned int n )
+{
+  __m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+  unsigned int i = 0;
+  for ( ; i+8<=n; i+=8 ) {
+    sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( a+i ), _mm_loadu_ps( b+i ) ) );
+    sum1 = _mm_add_ps( sum1, _mm_mul_ps( _mm_loadu_ps( a+i+4 ), _mm_loadu_ps( b+i+4 ) ) );
+  }
+  for ( ; i+4<=n; i+=4 )
+    sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( a+i ), _mm_loadu_ps( b+i ) ) );
+
+  __m128 sum = _mm_add_ps( sum0, sum1 );
+  sum = _mm_add_ps( sum, _mm_movehl_ps( sum, sum ) );
+  sum = _mm_add_ss( sum, _mm_shuffle_ps( sum, sum, 1 ) );
+
+  float result;
+  _mm_store_ss( &result, sum );
+  for ( ; i<n; i++ ) result += a[i] * b[i];
+  return result;
+}
+
+inline void multiply( float *d, const float *s, float gain, unsigned int n )
+{
+  const __m128 g = _mm_set1_ps( gain );
+  unsigned int i = 0;
+  for ( ; i+4<=n; i+=4 )
+    _mm_storeu_ps( d+i, _mm_mul_ps( _mm_loadu_ps( s+i ), g ) );
+  for ( ; i<n; i++ ) d[i] = s[i] * gain;
+}
+
+inline void multiplyAdd( float *d, const float *s, float gain, unsigned int n )
+{
+  const __m128 g = _mm_set1_ps( gain );
+  unsigned int i = 0;
+  for ( ; i+4<=n; i+=4 )
+    _mm_storeu_ps( d+i, _mm_add_ps( _mm_loadu_ps( d+i ), _mm_mul_ps( _mm_loadu_ps( s+i ), g ) ) );
+  for ( ; i<n; i++ ) d[i] += s[i] * gain;
+}
+
+inline void meshJunctions( const float *ix, const float *ixm, const float *iy, const float *iym,
+                           float *ox, float *oxm, float *oy, float *oym, unsigned int n )
+{
+  const __m128 half = _mm_set1_ps( 0.5f );
+  unsigned int i = 0;
+  for ( ; i+4<=n; i+=4 ) {
+    __m128 x = _mm_loadu_ps( ix+i ), xm = _mm_loadu_ps( ixm+i );
+    __m128 y = _mm_loadu_ps( iy+i ), ym = _mm_loadu_ps( iym+i );
+    __m128 v = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_add_ps( x, xm ), y ), ym ), half );
+    _mm_storeu_ps( ox+i, _mm_sub_ps( v, xm ) );
+    _mm_storeu_ps( oxm+i, _mm_sub_ps( v, x ) );
+    _mm_storeu_ps( oy+i, _mm_sub_ps( v, ym ) );
+    _mm_storeu_ps( oym+i, _mm_sub_ps( v, y ) );
+  }
+  for ( ; i<n; i++ ) {
+    float v = ( ix[i] + ixm[i] + iy[i] + iym[i] ) * 0.5f;
+    ox[i] = v - ixm[i]; oxm[i] = v - ix[i];
+    oy[i] = v - iym[i]; oym[i] = v - iy[i];
+  }
+}
+
+#endif
+
+} // vectorops namespace
+
+} // stk namespace
+
+#endif
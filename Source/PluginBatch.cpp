@@ -0,0 +1,307 @@
+//
+//  PluginBatch.cpp
+//  SynthPlugin
+//
+//  Offline rendering of MIDI files through the synth (see PluginBatch.h).
+//
+
+#include "PluginBatch.h"
+
+namespace APDI
+{
+
+enum { kNumberOfOutputChannels = 2 };
+
+//==============================================================================
+class BatchRenderer::Worker : public Thread
+{
+public:
+    Worker(BatchRenderer& renderer, int index)
+    :   Thread("Batch Render Thread " + String(index + 1)), owner(renderer) {}
+
+    void run() {
+        while(Job* job = owner.getNextJob()){
+            if(owner.completed.contains(job->output.getFullPathName()) && job->output.existsAsFile()){
+                job->bSkipped = true;
+            }else{
+                const double start = Time::getMillisecondCounterHiRes();
+                const Result result (owner.render(*job));
+                job->renderSeconds = (Time::getMillisecondCounterHiRes() - start) * 0.001;
+                job->error = result.getErrorMessage();
+            }
+
+            owner.finished(*job);
+        }
+    }
+
+private:
+    BatchRenderer& owner;
+
+    JUCE_DECLARE_NON_COPYABLE (Worker)
+};
+
+//==============================================================================
+BatchRenderer::BatchRenderer()
+:   pListener(NULL)
+{
+    formats.registerBasicFormats();
+}
+
+BatchRenderer::~BatchRenderer()
+{
+}
+
+Result BatchRenderer::loadManifest(const File& manifest)
+{
+    if(!manifest.existsAsFile())
+        return Result::fail("Couldn't find " + manifest.getFullPathName());
+
+    StringArray lines;
+    manifest.readLines(lines);
+
+    const File folder (manifest.getParentDirectory());
+
+    for(int l=0; l<lines.size(); l++){
+        const String line (lines[l].trim());
+        if(line.isEmpty() || line.startsWithChar('#'))
+            continue;
+
+        StringArray fields;
+        fields.addTokens(line, "\t", "\"");
+        fields.trim();
+        fields.removeEmptyStrings();
+
+        if(fields.size() != 3)
+            return Result::fail(manifest.getFileName() + " (line " + String(l + 1) + "): expected a MIDI file, preset and output file");
+
+        // presets that name a file are saved plugin states
+        const File presetFile (folder.getChildFile(fields[1].unquoted()));
+
+        addJob(folder.getChildFile(fields[0].unquoted()),
+               presetFile.existsAsFile() ? presetFile.getFullPathName() : fields[1].unquoted(),
+               folder.getChildFile(fields[2].unquoted()));
+    }
+
+    setCheckpointFile(manifest.withFileExtension("checkpoint"));
+    return Result::ok();
+}
+
+void BatchRenderer::addJob(const File& midiFile, const String& preset, const File& output)
+{
+    Job* job = jobs.add(new Job());
+    job->midiFile = midiFile;
+    job->preset = preset;
+    job->output = output;
+    job->bFinished = job->bSkipped = false;
+    job->renderSeconds = job->audioSeconds = 0.0;
+}
+
+void BatchRenderer::clearJobs()
+{
+    jobs.clear();
+}
+
+//==============================================================================
+Result BatchRenderer::run(const Settings& newSettings, Listener* listener)
+{
+    settings = newSettings;
+    pListener = listener;
+
+    for(int j=0; j<jobs.size(); j++){
+        Job& job = *jobs.getUnchecked(j);
+        job.bFinished = job.bSkipped = false;
+        job.error = String::empty;
+        job.renderSeconds = job.audioSeconds = 0.0;
+    }
+
+    nextJob.set(0);
+    numFinished.set(0);
+    bStopRequested.set(0);
+
+    // the checkpoint lists the outputs of finished jobs, one per line (followed by the job's timings)
+    completed.clear();
+    if(checkpoint != File::nonexistent){
+        StringArray lines;
+        checkpoint.readLines(lines);
+        for(int l=0; l<lines.size(); l++)
+            if(lines[l].isNotEmpty())
+                completed.add(lines[l].upToFirstOccurrenceOf("\t", false, false));
+
+        checkpointStream = checkpoint.createOutputStream(); // (appends)
+    }
+
+    const int numThreads = settings.numThreads > 0 ? settings.numThreads : SystemStats::getNumCpus();
+
+    OwnedArray<Worker> workers;
+    for(int t=0; t<numThreads; t++)
+        workers.add(new Worker(*this, t))->startThread();
+
+    for(int t=0; t<workers.size(); t++)
+        workers[t]->waitForThreadToExit(-1);
+
+    checkpointStream = nullptr;
+
+    if(bStopRequested.get())
+        return Result::fail("Stopped");
+
+    int numFailed = 0;
+    for(int j=0; j<jobs.size(); j++)
+        if(jobs[j]->error.isNotEmpty())
+            numFailed++;
+
+    if(numFailed)
+        return Result::fail(String(numFailed) + " of " + String(jobs.size()) + " jobs failed");
+
+    return Result::ok();
+}
+
+BatchRenderer::Job* BatchRenderer::getNextJob()
+{
+    if(bStopRequested.get())
+        return NULL;
+
+    const int index = (nextJob += 1) - 1;
+    return index < jobs.size() ? jobs.getUnchecked(index) : NULL;
+}
+
+void BatchRenderer::finished(Job& job)
+{
+    job.bFinished = true;
+    const int count = (numFinished += 1);
+
+    if(job.error.isEmpty() && !job.bSkipped && checkpointStream != nullptr){
+        const ScopedLock lock(checkpointLock);
+
+        *checkpointStream << job.output.getFullPathName() << "\t"
+                          << String(job.renderSeconds, 3) << "\t" << String(job.audioSeconds, 3) << newLine;
+        checkpointStream->flush();
+    }
+
+    if(pListener)
+        pListener->jobFinished(job, count, jobs.size());
+}
+
+//==============================================================================
+Result BatchRenderer::render(Job& job)
+{
+    MidiFile midiFile;
+    {
+        FileInputStream in (job.midiFile);
+        if(in.failedToOpen() || !midiFile.readFrom(in))
+            return Result::fail("Couldn't read " + job.midiFile.getFullPathName());
+    }
+    midiFile.convertTimestampTicksToSeconds();
+
+    MidiMessageSequence sequence;
+    for(int t=0; t<midiFile.getNumTracks(); t++)
+        sequence.addSequence(*midiFile.getTrack(t), 0.0, 0.0, midiFile.getLastTimestamp() + 1.0);
+
+    AudioFormat* format = formats.findFormatForFileExtension(job.output.getFileExtension());
+    if(format == nullptr)
+        return Result::fail("Unsupported output format: " + job.output.getFileName());
+
+    // a new instance for every job, so that nothing carries over from the last one
+    ScopedPointer<PluginAudioProcessor> processor (new PluginAudioProcessor());
+    processor->setNonRealtime(true);
+    processor->setPlayConfigDetails(0, kNumberOfOutputChannels, settings.sampleRate, settings.blockSize);
+    processor->prepareToPlay(settings.sampleRate, settings.blockSize);
+
+    const Result preset (applyPreset(*processor, job.preset));
+    if(preset.failed())
+        return preset;
+
+    // write to a temporary file first, so an interrupted job never leaves a partial output
+    job.output.getParentDirectory().createDirectory();
+    TemporaryFile temp (job.output);
+    ScopedPointer<AudioFormatWriter> writer;
+    {
+        ScopedPointer<FileOutputStream> out (temp.getFile().createOutputStream());
+        if(out != nullptr)
+            writer = format->createWriterFor(out, settings.sampleRate, kNumberOfOutputChannels,
+                                             settings.bitsPerSample, StringPairArray(), 0);
+        if(writer != nullptr)
+            out.release(); // now owned by the writer
+    }
+
+    if(writer == nullptr)
+        return Result::fail("Couldn't write " + job.output.getFullPathName());
+
+    const int64 length = (int64) ((sequence.getEndTime() + settings.tailSeconds) * settings.sampleRate);
+    AudioSampleBuffer buffer (kNumberOfOutputChannels, settings.blockSize);
+    MidiBuffer midi;
+    int event = 0;
+
+    for(int64 position = 0; position < length; position += settings.blockSize){
+        if(bStopRequested.get())
+            return Result::fail("Stopped");
+
+        const int numSamples = (int) jmin((int64) settings.blockSize, length - position);
+
+        buffer.setSize(kNumberOfOutputChannels, numSamples, false, false, true);
+        renderNextBlock(*processor, sequence, event, position, settings.sampleRate, buffer, midi);
+
+        if(!writer->writeFromAudioSampleBuffer(buffer, 0, numSamples))
+            return Result::fail("Couldn't write " + job.output.getFullPathName());
+    }
+
+    processor->releaseResources();
+
+    writer = nullptr; // (finishes the file)
+    if(!temp.overwriteTargetFileWithTemporary())
+        return Result::fail("Couldn't write " + job.output.getFullPathName());
+
+    job.audioSeconds = length / settings.sampleRate;
+    return Result::ok();
+}
+
+void BatchRenderer::renderNextBlock(AudioProcessor& processor, const MidiMessageSequence& sequence, int& nextEvent,
+                                    int64 position, double sampleRate, AudioSampleBuffer& buffer, MidiBuffer& midi)
+{
+    const int numSamples = buffer.getNumSamples();
+
+    midi.clear();
+    for(; nextEvent < sequence.getNumEvents(); nextEvent++){
+        const MidiMessage& message = sequence.getEventPointer(nextEvent)->message;
+        const int64 time = (int64) (message.getTimeStamp() * sampleRate);
+        if(time >= position + numSamples)
+            break;
+        if(!message.isMetaEvent())
+            midi.addEvent(message, (int) jmax((int64) 0, time - position));
+    }
+
+    buffer.clear();
+    processor.processBlock(buffer, midi);
+}
+
+Result BatchRenderer::applyPreset(PluginAudioProcessor& processor, const String& preset) const
+{
+    // a saved plugin state
+    if(File::isAbsolutePath(preset)){
+        MemoryBlock state;
+        if(!File(preset).loadFileAsData(state))
+            return Result::fail("Couldn't read " + preset);
+
+        processor.setStateInformation(state.getData(), (int) state.getSize());
+        return Result::ok();
+    }
+
+    // a program number or name (applied at the start of the first block)
+    if(preset.containsOnly("0123456789")){
+        const int index = preset.getIntValue();
+        if(index < processor.getNumPrograms()){
+            processor.setCurrentProgram(index);
+            return Result::ok();
+        }
+    }
+
+    for(int p=0; p<processor.getNumPrograms(); p++){
+        if(processor.getProgramName(p).equalsIgnoreCase(preset)){
+            processor.setCurrentProgram(p);
+            return Result::ok();
+        }
+    }
+
+    return Result::fail("Unknown preset: " + preset);
+}
+
+} // namespace APDI
@@ -0,0 +1,131 @@
+//
+//  PluginBatch.h
+//  SynthPlugin
+//
+//  Offline rendering of many MIDI files through the synth (e.g. to generate a
+//  dataset), spread across all the CPU cores.
+//
+//  Jobs are read from a manifest - a text file with one job per line, with the
+//  MIDI file, the preset and the output file separated by tabs:
+//
+//      # MIDI file             preset          output (.wav, or .flac if enabled)
+//      songs/song1.mid         Default         out/song1.wav
+//      songs/song2.mid         3               out/song2.wav
+//      songs/song3.mid         bright.state    out/song3.wav
+//
+//  Relative paths are relative to the manifest. The preset is a program name or
+//  number, or a file holding a saved plugin state (see getStateInformation()).
+//
+//  Each worker thread renders its current job with its own plugin instance,
+//  created afresh for every job, so the output never depends on which jobs
+//  a worker rendered before. Finished jobs are recorded in a checkpoint file,
+//  so an interrupted batch continues where it left off when it is run again.
+//
+//      BatchRenderer renderer;
+//      Result result (renderer.loadManifest (File ("~/corpus/jobs.txt")));
+//      if (result.wasOk())
+//          result = renderer.run();
+//
+
+#ifndef _PluginBatch_h_
+#define _PluginBatch_h_
+
+#include "PluginProcessor.h"
+
+namespace APDI
+{
+
+class BatchRenderer
+{
+public:
+    struct Job
+    {
+        File midiFile;
+        String preset;
+        File output;
+
+        // results (valid once the job has finished)
+        bool bFinished, bSkipped;       // skipped = already rendered, according to the checkpoint
+        String error;                   // empty if the job succeeded
+        double renderSeconds;           // time taken to render
+        double audioSeconds;            // length of the output
+    };
+
+    struct Settings
+    {
+        Settings()
+        :   sampleRate(44100.0), blockSize(512), bitsPerSample(24), tailSeconds(2.0), numThreads(0) {}
+
+        double sampleRate;
+        int blockSize;
+        int bitsPerSample;
+        double tailSeconds;     // rendered after the last MIDI event, for release tails
+        int numThreads;         // 0 for one per CPU core
+    };
+
+    /** Receives progress reports (called on the worker threads, so must be thread-safe). */
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+        virtual void jobFinished(const Job& job, int numFinished, int numJobs) = 0;
+    };
+
+    BatchRenderer();
+    ~BatchRenderer();
+
+    // Adds the jobs from a manifest (and uses a checkpoint file alongside it)
+    Result loadManifest(const File& manifest);
+
+    void addJob(const File& midiFile, const String& preset, const File& output);
+    void clearJobs();
+
+    // Finished jobs are recorded here (none, by default, unless loaded from a manifest)
+    void setCheckpointFile(const File& file) { checkpoint = file; }
+    const File& getCheckpointFile() const { return checkpoint; }
+
+    // Renders all the jobs, returning when they have finished (or stop() is called).
+    // Fails if any job failed (the others are still rendered).
+    Result run(const Settings& settings = Settings(), Listener* listener = NULL);
+
+    // Asks run() to return as soon as possible (from another thread)
+    void stop() { bStopRequested.set(1); }
+
+    int getNumJobs() const { return jobs.size(); }
+    const Job& getJob(int index) const { return *jobs.getUnchecked(index); }
+
+    double getProgress() const { return jobs.size() ? (double) numFinished.get() / jobs.size() : 1.0; }
+
+    // Renders the next block of a MIDI sequence (timestamped in seconds) through a prepared processor,
+    // starting at the given sample position. The block's length is the size of the buffer, and
+    // nextEvent is the index of the first event that hasn't been played yet (so starts at 0).
+    static void renderNextBlock(AudioProcessor& processor, const MidiMessageSequence& sequence, int& nextEvent,
+                                int64 position, double sampleRate, AudioSampleBuffer& buffer, MidiBuffer& midi);
+
+private:
+    class Worker;
+    friend class Worker;
+
+    Job* getNextJob();
+    void finished(Job& job);
+    Result render(Job& job);
+    Result applyPreset(PluginAudioProcessor& processor, const String& preset) const;
+
+    OwnedArray<Job> jobs;
+    File checkpoint;
+    SortedSet<String> completed;            // outputs listed in the checkpoint
+
+    AudioFormatManager formats;
+    Settings settings;
+    Listener* pListener;
+
+    Atomic<int> nextJob, numFinished, bStopRequested;
+    CriticalSection checkpointLock;
+    ScopedPointer<FileOutputStream> checkpointStream;
+
+    JUCE_DECLARE_NON_COPYABLE (BatchRenderer)
+};
+
+} // namespace APDI
+
+#endif
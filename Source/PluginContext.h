@@ -0,0 +1,137 @@
+//
+//  PluginContext.h
+//  SynthPlugin
+//
+//  The processing context of a plugin instance: its sample rate, block size and
+//  scratch memory for the audio thread. Each PluginAudioProcessor owns a Context,
+//  and activates it (with a Context::Scope) whenever it calls into the synth, so
+//  that the APDI and STK objects used on that thread see the instance's own rate,
+//  rather than the process-wide stk::Stk rate. Instances at different rates can
+//  then share a process, and render at the same time on separate threads.
+//
+
+#ifndef _PluginContext_h_
+#define _PluginContext_h_
+
+#include <pthread.h>
+
+namespace APDI
+{
+
+class Context
+{
+public:
+    enum { kScratchChannels = 8 }; // scratch memory is reserved for this many channels of a block
+
+    Context(double sampleRate = 44100.0, int blockSize = 512)
+    :   fSampleRate(sampleRate), iBlockSize(0), iScratchSize(0), iScratchUsed(0)
+    {
+        prepare(sampleRate, blockSize);
+    }
+
+    // Sets the sample rate and block size, and reserves scratch memory (not for the audio thread)
+    void prepare(double sampleRate, int blockSize) {
+        jassert(iScratchUsed == 0); // not while scratch memory is in use!
+
+        // re-tune the STK objects created with this context that ask to be told (e.g. stk::SineWave)
+        const stk::StkFloat previousRate = fSampleRate;
+        fSampleRate = sampleRate;
+        stk::Stk::threadSampleRateChanged(&fSampleRate, previousRate);
+        iBlockSize = blockSize;
+
+        const int size = kScratchChannels * align(blockSize);
+        if(size != iScratchSize){
+            scratch.allocate(size, true);
+            iScratchSize = size;
+        }
+    }
+
+    double getSampleRate() const { return fSampleRate; }
+    int getBlockSize() const { return iBlockSize; }
+
+    //==========================================================================
+    /** Takes memory from the context's scratch space, which is all given back when
+        the ScratchScope ends. Allocations fail (returning NULL) when the space runs out,
+        e.g. if the host asks for a larger block than it said it would. */
+    class ScratchScope
+    {
+    public:
+        ScratchScope(Context* context) : pContext(context), iMark(context ? context->iScratchUsed : 0) {}
+        ~ScratchScope() { if(pContext) pContext->iScratchUsed = iMark; }
+
+        float* allocate(int numSamples) {
+            if(pContext == NULL || pContext->iScratchUsed + align(numSamples) > pContext->iScratchSize)
+                return NULL;
+
+            float* data = pContext->scratch + pContext->iScratchUsed;
+            pContext->iScratchUsed += align(numSamples);
+            return data;
+        }
+
+        // Fills an array of channel pointers (returns false if there's not enough space)
+        bool allocate(float** channels, int numChannels, int numSamples) {
+            for(int c=0; c<numChannels; c++)
+                if((channels[c] = allocate(numSamples)) == NULL)
+                    return false;
+            return true;
+        }
+
+    private:
+        Context* pContext;
+        const int iMark;
+
+        JUCE_DECLARE_NON_COPYABLE (ScratchScope)
+    };
+
+    //==========================================================================
+    // The context active on the calling thread (or NULL, outside any Scope)
+    static Context* getCurrent() { return static_cast<Context*>(pthread_getspecific(getKey())); }
+
+    /** Activates a context on the calling thread, for the lifetime of this object. */
+    class Scope
+    {
+    public:
+        Scope(Context& context)
+        :   pPrevious(getCurrent()), pPreviousRate(stk::Stk::setThreadSampleRate(&context.fSampleRate))
+        {
+            pthread_setspecific(getKey(), &context);
+        }
+
+        ~Scope() {
+            stk::Stk::setThreadSampleRate(pPreviousRate);
+            pthread_setspecific(getKey(), pPrevious);
+        }
+
+    private:
+        Context* pPrevious;
+        const stk::StkFloat* pPreviousRate;
+
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+
+private:
+    static int align(int numSamples) { return (numSamples + 3) & ~3; } // keeps allocations 16-byte aligned
+
+    static pthread_key_t getKey() {
+        static const pthread_key_t key = createKey();
+        return key;
+    }
+
+    static pthread_key_t createKey() {
+        pthread_key_t key;
+        pthread_key_create(&key, NULL);
+        return key;
+    }
+
+    stk::StkFloat fSampleRate;
+    int iBlockSize;
+
+    HeapBlock<float> scratch;
+    int iScratchSize, iScratchUsed;
+
+    JUCE_DECLARE_NON_COPYABLE (Context)
+};
+
+} // namespace APDI
+
+#endif
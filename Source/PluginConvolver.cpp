@@ -0,0 +1,307 @@
+//
+//  PluginConvolver.cpp
+//  SynthPlugin
+//
+//  Uniformly partitioned convolution (see PluginConvolver.h).
+//
+//  Each block of input is transformed once (with the block before it, for
+//  overlap-save), and its spectrum kept in a ring - the frequency-domain delay
+//  line. A block of output is then the inverse transform of the sum of the
+//  spectra of the last N blocks, each multiplied by a partition of the impulse
+//  response. Spectra are stored as the FFT leaves them: fftSize/2 real parts,
+//  then fftSize/2 imaginary parts, with the (real) DC and Nyquist bins packed
+//  into the first of each.
+//
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "PluginSanitizer.h"
+#include "PluginDenormals.h"
+#include "PluginConvolver.h"
+
+#if JUCE_MAC || JUCE_IOS || DROWAUDIO_USE_FFTREAL
+
+namespace APDI
+{
+
+//==============================================================================
+class Convolver::TailThread : public Thread
+{
+public:
+    TailThread(Convolver& convolver) : Thread("Convolution Tail Thread"), owner(convolver) {}
+
+    ~TailThread() {
+        stopThread(2000);
+    }
+
+    void run() {
+        const ScopedNoDenormals noDenormals;
+
+        while(!threadShouldExit()){
+            const int64 next = owner.lastComputed.get() + 1;
+            if(next > owner.lastRequested.get()){
+                wait(100);
+                continue;
+            }
+
+            owner.computeTail(next + owner.iNumHead);
+            owner.lastComputed.set(next);
+            owner.tailReady.signal();
+        }
+    }
+
+private:
+    Convolver& owner;
+
+    JUCE_DECLARE_NON_COPYABLE (TailThread)
+};
+
+//==============================================================================
+Convolver::Convolver()
+:   response(1, 1), iResponseSize(0), iPartitionSize(0), iNumPartitions(0), iNumHead(0), iNumSpectra(0),
+    iInputFill(0), iBlock(0), bUseThread(false)
+{
+}
+
+Convolver::~Convolver()
+{
+    tailThread = nullptr;
+}
+
+void Convolver::setImpulseResponse(const AudioSampleBuffer& newResponse, int numSamples)
+{
+    iResponseSize = jmin(numSamples, newResponse.getNumSamples());
+    response.setSize(jmax(1, newResponse.getNumChannels()), jmax(1, iResponseSize));
+    response.clear();
+    for(int c=0; c<newResponse.getNumChannels(); c++)
+        response.copyFrom(c, 0, newResponse, c, 0, iResponseSize);
+
+    if(channels.size() > 0)
+        prepare(channels.size(), iPartitionSize, bUseThread);
+}
+
+Result Convolver::loadImpulseResponse(const File& file, double sampleRate)
+{
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    ScopedPointer<AudioFormatReader> reader (formats.createReaderFor(file));
+    if(reader == nullptr)
+        return Result::fail("Couldn't read " + file.getFullPathName());
+
+    if(reader->sampleRate != sampleRate)
+        return Result::fail(file.getFileName() + " is at " + String(reader->sampleRate) + "Hz, not " + String(sampleRate) + "Hz");
+
+    const int numSamples = (int) reader->lengthInSamples;
+    AudioSampleBuffer buffer (jmin(2, (int) reader->numChannels), jmax(1, numSamples));
+    reader->read(&buffer, 0, numSamples, 0, true, true);
+
+    setImpulseResponse(buffer, numSamples);
+    return Result::ok();
+}
+
+void Convolver::prepare(int numChannels, int blockSize, bool useBackgroundThread)
+{
+    tailThread = nullptr;
+
+    iPartitionSize = nextPowerOfTwo(jmax(1, blockSize));
+    const int fftSize = 2 * iPartitionSize;
+
+    if(fft == nullptr || fft->getFFTProperties().fftSize != fftSize){
+        int fftSizeLog2 = 0;
+        while((1 << fftSizeLog2) < fftSize)
+            fftSizeLog2++;
+        fft = new drow::FFTOperation(fftSizeLog2);
+    }
+
+    iNumPartitions = jmax(1, (iResponseSize + iPartitionSize - 1) / iPartitionSize);
+    bUseThread = useBackgroundThread;
+    iNumHead = bUseThread && iNumPartitions > kHeadPartitions ? (int) kHeadPartitions : iNumPartitions;
+    iNumSpectra = iNumPartitions + iNumHead;
+    const int numTails = iNumHead < iNumPartitions ? iNumHead : 0;
+
+    accumulator.allocate(fftSize, true);
+    time.allocate(fftSize, true);
+
+    channels.clear();
+    for(int c=0; c<numChannels; c++){
+        Channel* channel = channels.add(new Channel());
+        channel->input.allocate(fftSize, true);
+        channel->output.allocate(iPartitionSize, true);
+        channel->spectra.allocate(iNumSpectra * fftSize, true);
+        channel->tails.allocate(jmax(1, numTails * fftSize), true);
+    }
+
+    partition();
+    reset();
+}
+
+void Convolver::reset()
+{
+    tailThread = nullptr;
+
+    const int fftSize = 2 * iPartitionSize;
+    const int numTails = iNumHead < iNumPartitions ? iNumHead : 0;
+
+    for(int c=0; c<channels.size(); c++){
+        Channel& channel = *channels.getUnchecked(c);
+        zeromem(channel.input, fftSize * sizeof(float));
+        zeromem(channel.output, iPartitionSize * sizeof(float));
+        zeromem(channel.spectra, iNumSpectra * fftSize * sizeof(float));
+        zeromem(channel.tails, numTails * fftSize * sizeof(float));
+    }
+
+    iInputFill = 0;
+    iBlock = 0;
+    lastRequested.set(-1);
+    lastComputed.set(-1);
+
+    if(numTails > 0){
+        tailThread = new TailThread(*this);
+        tailThread->startThread(8); // high, as it has a deadline
+    }
+}
+
+//==============================================================================
+void Convolver::process(float** buffers, int numChannels, int numSamples)
+{
+    if(channels.size() == 0)
+        return;
+
+    numChannels = jmin(numChannels, channels.size());
+
+    // the input is gathered into blocks, which are convolved once full - so each
+    // sample's output comes out exactly one block later
+    int done = 0;
+    while(done < numSamples){
+        const int count = jmin(numSamples - done, iPartitionSize - iInputFill);
+
+        for(int c=0; c<numChannels; c++){
+            Channel& channel = *channels.getUnchecked(c);
+            FloatVectorOperations::copy(channel.input + iPartitionSize + iInputFill, buffers[c] + done, count);
+            FloatVectorOperations::copy(buffers[c] + done, channel.output + iInputFill, count);
+        }
+
+        iInputFill += count;
+        done += count;
+
+        if(iInputFill == iPartitionSize){
+            convolveBlock();
+            iInputFill = 0;
+        }
+    }
+}
+
+void Convolver::convolveBlock()
+{
+    const int fftSize = 2 * iPartitionSize;
+    float* const spectrum = fft->getFFTBuffer().realp; // (followed by imagp)
+
+    // the tail should be long finished, unless the machine is overloaded
+    if(tailThread != nullptr && lastComputed.get() < iBlock - iNumHead){
+        const RealtimeSanitizer::ScopedNonRealtime wait;
+        while(lastComputed.get() < iBlock - iNumHead)
+            tailReady.wait(1);
+    }
+
+    for(int c=0; c<channels.size(); c++){
+        Channel& channel = *channels.getUnchecked(c);
+
+        fft->performFFT(channel.input);
+        memcpy(getSpectrum(channel, iBlock), spectrum, fftSize * sizeof(float));
+        memcpy(channel.input, channel.input + iPartitionSize, iPartitionSize * sizeof(float));
+
+        if(tailThread != nullptr)
+            memcpy(accumulator, channel.tails + (iBlock % iNumHead) * fftSize, fftSize * sizeof(float));
+        else
+            zeromem(accumulator, fftSize * sizeof(float));
+
+        for(int p=0; p<iNumHead; p++)
+            multiplyAdd(accumulator, getSpectrum(channel, iBlock - p), getResponse(c, p), iPartitionSize);
+
+        memcpy(spectrum, accumulator, fftSize * sizeof(float));
+        fft->performInverseFFT(time);
+
+        // overlap-save keeps only the second half
+        memcpy(channel.output, time + iPartitionSize, iPartitionSize * sizeof(float));
+    }
+
+    iBlock++;
+
+    if(tailThread != nullptr){
+        lastRequested.set(iBlock - 1);
+
+        const RealtimeSanitizer::ScopedNonRealtime wake; // (signalling takes an uncontended lock)
+        tailThread->notify();
+    }
+}
+
+void Convolver::computeTail(int64 block)
+{
+    const int fftSize = 2 * iPartitionSize;
+
+    for(int c=0; c<channels.size(); c++){
+        const Channel& channel = *channels.getUnchecked(c);
+        float* const tail = channel.tails + (block % iNumHead) * fftSize;
+
+        zeromem(tail, fftSize * sizeof(float));
+        for(int p=iNumHead; p<iNumPartitions; p++)
+            multiplyAdd(tail, getSpectrum(channel, block - p), getResponse(c, p), iPartitionSize);
+    }
+}
+
+//==============================================================================
+void Convolver::partition()
+{
+    const int fftSize = 2 * iPartitionSize;
+    const float scale = 1.0f / fft->getForwardScale(); // so the product of two spectra comes back at unity gain
+
+    responseSpectra.allocate(response.getNumChannels() * iNumPartitions * fftSize, true);
+
+    for(int c=0; c<response.getNumChannels(); c++){
+        for(int p=0; p<iNumPartitions; p++){
+            // each partition is zero-padded to the FFT size
+            const int start = p * iPartitionSize;
+            zeromem(time, fftSize * sizeof(float));
+            if(start < iResponseSize)
+                FloatVectorOperations::copy(time, response.getSampleData(c, start), jmin(iPartitionSize, iResponseSize - start));
+
+            fft->performFFT(time);
+
+            float* const destination = const_cast<float*>(getResponse(c, p));
+            FloatVectorOperations::copyWithMultiply(destination, fft->getFFTBuffer().realp, scale, fftSize);
+        }
+    }
+}
+
+float* Convolver::getSpectrum(const Channel& channel, int64 block) const
+{
+    // (blocks before the first map to slots not yet written, which are still zero)
+    const int64 slot = ((block % iNumSpectra) + iNumSpectra) % iNumSpectra;
+    return channel.spectra + slot * 2 * iPartitionSize;
+}
+
+const float* Convolver::getResponse(int channel, int partition) const
+{
+    const int c = jmin(channel, response.getNumChannels() - 1);
+    return responseSpectra + (c * iNumPartitions + partition) * 2 * iPartitionSize;
+}
+
+void Convolver::multiplyAdd(float* result, const float* a, const float* b, int size)
+{
+    float* const resultImag = result + size;
+    const float* const aImag = a + size;
+    const float* const bImag = b + size;
+
+    // DC and Nyquist are real
+    result[0] += a[0] * b[0];
+    resultImag[0] += aImag[0] * bImag[0];
+
+    for(int i=1; i<size; i++){
+        result[i] += a[i] * b[i] - aImag[i] * bImag[i];
+        resultImag[i] += a[i] * bImag[i] + aImag[i] * b[i];
+    }
+}
+
+} // namespace APDI
+
+#endif
@@ -0,0 +1,106 @@
+//
+//  PluginConvolver.h
+//  SynthPlugin
+//
+//  Convolution with long impulse responses (e.g. reverbs and cabinet models),
+//  for use in a synth's postProcess(). Unlike stk::Fir, which costs O(N) per
+//  sample, the impulse response is split into uniform partitions of the block
+//  size, which are convolved in the frequency domain (overlap-save, using the
+//  dRowAudio FFT), so a one second response costs a few percent of a core.
+//
+//  The latency is one block (the block size, rounded up to a power of two).
+//  With a background thread, only the first few partitions are convolved on
+//  the audio thread, and the rest (the tail) on the background thread, which
+//  has a few blocks to deliver each result before it's needed.
+//
+//      void MySynth::postProcess(float** outputBuffer, int numChannels, int numSamples)
+//      {
+//          reverb.process(outputBuffer, numChannels, numSamples);
+//      }
+//
+//  ...with reverb.loadImpulseResponse() and reverb.prepare() called beforehand,
+//  off the audio thread (e.g. with the block size from Context::getCurrent()).
+//
+
+#ifndef _PluginConvolver_h_
+#define _PluginConvolver_h_
+
+#if JUCE_MAC || JUCE_IOS || DROWAUDIO_USE_FFTREAL
+
+namespace APDI
+{
+
+class Convolver
+{
+public:
+    enum { kHeadPartitions = 4 };   // convolved on the audio thread, when there's a background thread
+
+    Convolver();
+    ~Convolver();
+
+    // Sets the impulse response (not on the audio thread, or while it's processing). Each channel
+    // is convolved with the same channel of the response, or its last channel if it has fewer.
+    void setImpulseResponse(const AudioSampleBuffer& response, int numSamples);
+
+    // Reads the impulse response from an audio file (it must already be at the right sample rate)
+    Result loadImpulseResponse(const File& file, double sampleRate);
+
+    // Allocates everything needed to process blocks of up to the given size (not on the audio thread)
+    void prepare(int numChannels, int blockSize, bool useBackgroundThread = true);
+
+    // Clears the input history and any output still to come (not on the audio thread)
+    void reset();
+
+    int getLatency() const { return iPartitionSize; }
+    int getNumPartitions() const { return iNumPartitions; }
+
+    // Convolves the channels in place (any number of samples per call)
+    void process(float** channels, int numChannels, int numSamples);
+
+private:
+    class TailThread;
+    friend class TailThread;
+
+    struct Channel
+    {
+        HeapBlock<float> input;         // the last two blocks of input (overlap-save)
+        HeapBlock<float> output;        // the last block of output (played one block later)
+        HeapBlock<float> spectra;       // the input's recent spectra (a ring of iNumSpectra)
+        HeapBlock<float> tails;         // the tail's results (a ring of iNumHead, with a background thread)
+    };
+
+    void partition();
+    void convolveBlock();
+    void computeTail(int64 block);
+
+    float* getSpectrum(const Channel& channel, int64 block) const;
+    const float* getResponse(int channel, int partition) const;
+
+    static void multiplyAdd(float* result, const float* a, const float* b, int size);
+
+    AudioSampleBuffer response;
+    int iResponseSize;
+
+    ScopedPointer<drow::FFTOperation> fft;
+    HeapBlock<float> responseSpectra;   // each partition of each channel of the response
+    HeapBlock<float> accumulator, time;
+
+    OwnedArray<Channel> channels;
+    int iPartitionSize, iNumPartitions, iNumHead, iNumSpectra;
+    int iInputFill;
+    int64 iBlock;
+    bool bUseThread;
+
+    // with a background thread, the tail for block b is computed once block b - iNumHead has been processed
+    ScopedPointer<TailThread> tailThread;
+    Atomic<int64> lastRequested, lastComputed;
+    WaitableEvent tailReady;
+
+    JUCE_DECLARE_NON_COPYABLE (Convolver)
+};
+
+} // namespace APDI
+
+#endif
+
+#endif
@@ -0,0 +1,109 @@
+//
+//  PluginDenormals.cpp
+//  SynthPlugin
+//
+//  A benchmark of the denormal protection (see PluginDenormals.h), built with
+//  the regression tests (APDI_REGRESSION_TESTS) - run it with a UnitTestRunner.
+//
+
+#include "PluginProcessor.h"
+
+#include <ctime>
+#include <cfloat>
+
+namespace APDI
+{
+
+#if APDI_REGRESSION_TESTS
+
+class DenormalBenchmark : public UnitTest
+{
+public:
+    DenormalBenchmark() : UnitTest("DenormalBenchmark") {}
+
+    enum Protection { kNone, kScopedNoDenormals, kFlush };
+
+    void runTest() {
+        beginTest("Decaying tails");
+
+        int denormals[3];
+        const double seconds[3] = { render(kNone, denormals[0]), render(kScopedNoDenormals, denormals[1]), render(kFlush, denormals[2]) };
+        const char* names[3] = { "Unprotected", "ScopedNoDenormals", "flush() per block" };
+
+        for(int p=0; p<3; p++)
+            logMessage(String(names[p]) + ": " + String(seconds[p], 3) + "s CPU (" + String(seconds[0] / jmax(seconds[p], 1.0e-6), 1)
+                       + "x), " + String(denormals[p]) + " denormal samples");
+
+       #if JUCE_INTEL || JUCE_ARM
+        expectEquals(denormals[kScopedNoDenormals], 0);
+       #endif
+        // (a fast-decaying state can still pass through denormals between flushes)
+        expect(denormals[kFlush] < denormals[kNone] / 10, "flush() should remove most denormals");
+    }
+
+private:
+    enum { kSeconds = 10, kBlockSize = 512, kNumFilters = 8 };
+
+    // A chain of filters with delayed feedback (as a voice's filters and a global echo)
+    struct Chain
+    {
+        Chain() : fFeedback(0.0f), fInput(1.0f) {
+            for(int f=0; f<kNumFilters; f++)
+                filters[f].setCutoff(2000.0f);
+            delay.setDelay(441.0f);
+        }
+
+        // renders a block of the impulse's tail, counting the denormal samples
+        void process(int& denormals) {
+            for(int i=0; i<kBlockSize; i++){
+                float fSample = fInput + 0.9f * fFeedback;
+                fInput = 0.0f;
+
+                for(int f=0; f<kNumFilters; f++)
+                    fSample = filters[f].tick(fSample);
+                fFeedback = delay.tick(fSample);
+
+                if(fSample != 0.0f && std::abs(fSample) < FLT_MIN)
+                    denormals++;
+            }
+        }
+
+        void flush() {
+            for(int f=0; f<kNumFilters; f++)
+                filters[f].flush();
+            delay.flush();
+        }
+
+        LPF filters[kNumFilters];
+        Delay delay;
+        float fFeedback, fInput;
+    };
+
+    // Renders the chain's tail with the given protection, returning the CPU time it took.
+    static double render(Protection protection, int& denormals) {
+        Chain chain;
+        const int numBlocks = (int)(kSeconds * getSampleRate()) / kBlockSize;
+        denormals = 0;
+
+        const std::clock_t start = std::clock();
+
+        for(int b=0; b<numBlocks; b++){
+            if(protection == kScopedNoDenormals){
+                const ScopedNoDenormals noDenormals;
+                chain.process(denormals);
+            }else{
+                chain.process(denormals);
+                if(protection == kFlush)
+                    chain.flush();
+            }
+        }
+
+        return (double)(std::clock() - start) / CLOCKS_PER_SEC;
+    }
+};
+
+static DenormalBenchmark denormalBenchmark;
+
+#endif // APDI_REGRESSION_TESTS
+
+} // namespace APDI
@@ -5,9 +5,12 @@
 PluginAudioProcessorEditor::PluginAudioProcessorEditor (PluginAudioProcessor* ownerFilter)
     : AudioProcessorEditor (ownerFilter),
       midiKeyboard (ownerFilter->keyboardState, MidiKeyboardComponent::horizontalKeyboard),
-      scope_mode(SCOPE_VISIBLE|SCOPE_SONOGRAM), oscilloscope(NULL), spectrum(NULL), sonogram(NULL), scopeThread("Scope Thread"),
-      tabScope(TabbedButtonBar::TabsAtTop), infoLabel (String::empty)
+      scope_mode(SCOPE_HIDDEN), bScopeVisible(false), oscilloscope(NULL), spectrum(NULL), sonogram(NULL), scopeThread("Scope Thread"),
+      tabScope(TabbedButtonBar::TabsAtTop), infoLabel (String::empty),
+      iDisplayedEditChannel(0), bDisplayedMultitimbral(false)
 {
+    setOpaque(true);
+    
     // add controls..
     for(int c=0; c<kNumberOfControls; c++){
         
@@ -59,21 +62,11 @@ PluginAudioProcessorEditor::PluginAudioProcessorEditor (PluginAudioProcessor* ow
     }
     
     
-    // add an oscilloscope..
-    oscilloscope = new AudioOscilloscope();
-    oscilloscope->setHorizontalZoom(0.001);
-    oscilloscope->setTraceColour(Colours::white);
-    
-    spectrum = new Spectroscope(10);
-    spectrum->setLogFrequencyDisplay(true);
-    
-    sonogram = new Sonogram(10);
-    sonogram->setLogFrequencyDisplay(true);
-    
+    // add the analysers' tabs (each analyser is created when its tab is first shown - see showScope)
     addAndMakeVisible(&tabScope);
-    tabScope.addTab("Oscilloscope", Colours::whitesmoke, oscilloscope, false, 0);
-    tabScope.addTab("Spectrum", Colours::whitesmoke, spectrum, false, 1);
-    tabScope.addTab("Sonogram", Colours::whitesmoke, sonogram, false, 2);
+    tabScope.addTab("Oscilloscope", Colours::whitesmoke, &scopePanels[0], false, 0);
+    tabScope.addTab("Spectrum", Colours::whitesmoke, &scopePanels[1], false, 1);
+    tabScope.addTab("Sonogram", Colours::whitesmoke, &scopePanels[2], false, 2);
     tabScope.setTabBarDepth(24);
     tabScope.setIndent(4);
 
@@ -95,7 +88,7 @@ PluginAudioProcessorEditor::PluginAudioProcessorEditor (PluginAudioProcessor* ow
 
 PluginAudioProcessorEditor::~PluginAudioProcessorEditor()
 {
-    scope_mode = SCOPE_HIDDEN;
+    showScope(SCOPE_HIDDEN);
     
     removeChildComponent(&tabScope);
 
@@ -106,33 +99,79 @@ PluginAudioProcessorEditor::~PluginAudioProcessorEditor()
         delete controls[c];
         controls[c] = NULL;
     }
+}
+
+void PluginAudioProcessorEditor::userTriedToCloseWindow(){
+    bScopeVisible = false;
+    showScope(SCOPE_HIDDEN);
+}
+
+// Shows (and feeds) one of the analysers, creating it if it's the first time, and pausing
+// the one shown before (mode is SCOPE_HIDDEN, or SCOPE_VISIBLE with one of the analysers)
+void PluginAudioProcessorEditor::showScope(int mode)
+{
+    if(mode == scope_mode)
+        return;
+    
+    // stop feeding the previous analyser (so the audio thread costs nothing while hidden)
+    getProcessor()->getScopeFeed().connect(NULL);
     
-    delete spectrum;
-    spectrum = NULL;
+    for(int s=0; s<kNumScopes; s++)
+        scopePanels[s].setPaused(!(mode & (SCOPE_OSCILLOSCOPE << s)));
     
-    delete sonogram;
-    sonogram = NULL;
+    if((mode & SCOPE_OSCILLOSCOPE) && !oscilloscope){
+        oscilloscope = new AudioOscilloscope();
+        oscilloscope->setHorizontalZoom(0.001);
+        oscilloscope->setTraceColour(Colours::white);
+        scopePanels[0].setScope(oscilloscope);
+    }else if((mode & SCOPE_SPECTRUM) && !spectrum){
+        spectrum = new Spectroscope(10);
+        spectrum->setLogFrequencyDisplay(true);
+        scopePanels[1].setScope(spectrum);
+    }else if((mode & SCOPE_SONOGRAM) && !sonogram){
+        sonogram = new Sonogram(10);
+        sonogram->setLogFrequencyDisplay(true);
+        scopePanels[2].setScope(sonogram);
+    }
+    
+    scope_mode = mode;
     
-    delete oscilloscope;
-    oscilloscope = NULL;
+    if(scope_mode & SCOPE_VISIBLE)
+        getProcessor()->getScopeFeed().connect(this);
 }
 
-void PluginAudioProcessorEditor::userTriedToCloseWindow(){
-    scope_mode = SCOPE_HIDDEN;
+// Called on the audio thread with the plugin's output, while an analyser is shown
+void PluginAudioProcessorEditor::feedScope(const float* samples, int numSamples)
+{
+    if(scope_mode & SCOPE_OSCILLOSCOPE)
+        oscilloscope->processBlock(samples, numSamples);
+    else if(scope_mode & SCOPE_SPECTRUM)
+        spectrum->copySamples(samples, numSamples);
+    else if(scope_mode & SCOPE_SONOGRAM)
+        sonogram->copySamples(samples, numSamples);
 }
 
 //==============================================================================
 void PluginAudioProcessorEditor::paint (Graphics& g)
 {
-    g.setGradientFill (ColourGradient (Colours::white, 0, 0, Colours::grey, 0, (float) getHeight(), false));
-    g.fillAll();
+    // (only the dirty region is drawn, from the cached gradient)
+    if (background.getWidth() != getWidth() || background.getHeight() != getHeight())
+    {
+        background = Image (Image::RGB, jmax (1, getWidth()), jmax (1, getHeight()), false);
+        
+        Graphics bg (background);
+        bg.setGradientFill (ColourGradient (Colours::white, 0, 0, Colours::grey, 0, (float) getHeight(), false));
+        bg.fillAll();
+    }
+    
+    g.drawImageAt (background, 0, 0);
 }
 
 void PluginAudioProcessorEditor::resized()
 {
     const int keyboardHeight = 70;
     
-    Bounds size;
+    Rectangle<int> size;
     for(int c=0; c<kNumberOfControls; c++){
         if(UI_CONTROLS[c].size == AUTO_SIZE){
             int column = c % 5;
@@ -166,7 +205,7 @@ void PluginAudioProcessorEditor::resized()
 
     resizer->setBounds (getWidth() - 16, getHeight() - 16, 16, 16);
     
-    scope_mode = (scope_mode & ~SCOPE_VISIBLE) | (getWidth() > 400 ? SCOPE_VISIBLE : SCOPE_HIDDEN);
+    bScopeVisible = getWidth() > 400;
     
     getProcessor()->lastUIWidth = getWidth();
     getProcessor()->lastUIHeight = getHeight();
@@ -183,7 +222,19 @@ void PluginAudioProcessorEditor::timerCallback()
     if (lastDisplayedPosition != newPos)
         displayPositionInfo (newPos);
 
-    for(int c=0; c<kNumberOfControls && controls[c]; c++){
+    // update only the controls whose parameters have changed (all of them, if the parameters
+    // being edited are a different channel's)
+    uint32 changed[PluginParameters<kNumberOfParameters>::kChangeWords];
+    const bool bChanged = ourProcessor->takeParameterChanges(changed);
+    const bool bRefreshAll = ourProcessor->getEditChannel() != iDisplayedEditChannel
+                          || ourProcessor->isMultitimbral() != bDisplayedMultitimbral;
+    iDisplayedEditChannel = ourProcessor->getEditChannel();
+    bDisplayedMultitimbral = ourProcessor->isMultitimbral();
+    
+    for(int c=0; (bChanged || bRefreshAll) && c<kNumberOfControls && controls[c]; c++){
+        if(!bRefreshAll && !(changed[c >> 5] & (1u << (c & 31))))
+            continue;
+        
         switch (UI_CONTROLS[c].type){
         case ROTARY:
         case SLIDER:
@@ -195,14 +246,19 @@ void PluginAudioProcessorEditor::timerCallback()
         case BUTTON:
             break;
         case TOGGLE:
-            ((TextButton*)controls[c])->setToggleState(ourProcessor->getParameter(c) != 0.0, sendNotification);
+            // (the value came from the processor, so it isn't sent back to it)
+            ((TextButton*)controls[c])->setToggleState(ourProcessor->getParameter(c) != 0.0, dontSendNotification);
             break;
         }
     }
     
+    // show the current tab's analyser, unless the editor is hidden or minimised
+    if (bScopeVisible && isShowing())
+        showScope(SCOPE_VISIBLE | (SCOPE_OSCILLOSCOPE << tabScope.getCurrentTabIndex()));
+    else
+        showScope(SCOPE_HIDDEN);
+    
     if (scope_mode & SCOPE_VISIBLE) {
-        scope_mode = SCOPE_VISIBLE | (2 << tabScope.getCurrentTabIndex());
-        
         if(spectrum && (scope_mode & SCOPE_SPECTRUM)){
             spectrum->process();
             spectrum->timerCallback();
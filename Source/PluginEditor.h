@@ -16,6 +16,48 @@ enum UI_MODE
     SCOPE_SONOGRAM = 8
 };
 
+//==============================================================================
+/** A tab's panel for one of the analysers, which is only created when the tab is first
+    shown, and paused (its timer stopped) while it's hidden. */
+class ScopePanel : public Component
+{
+public:
+    ScopePanel() : timer(NULL), iTimerInterval(0) {}
+    
+    template <class ScopeType>
+    void setScope(ScopeType* scope)
+    {
+        content = scope;
+        timer = scope;
+        addAndMakeVisible(scope);
+        resized();
+    }
+    
+    void setPaused(bool shouldPause)
+    {
+        if(!timer)
+            return;
+        
+        if(shouldPause && timer->isTimerRunning()){
+            iTimerInterval = timer->getTimerInterval();
+            timer->stopTimer();
+        }else if(!shouldPause && !timer->isTimerRunning() && iTimerInterval > 0){
+            timer->startTimer(iTimerInterval);
+        }
+    }
+    
+    void resized()
+    {
+        if(content)
+            content->setBounds(getLocalBounds());
+    }
+    
+private:
+    ScopedPointer<Component> content;
+    Timer* timer;
+    int iTimerInterval;
+};
+
 //==============================================================================
 /** This is the editor component that our filter will display.
 */
@@ -23,7 +65,8 @@ class PluginAudioProcessorEditor  : public AudioProcessorEditor,
                                             public SliderListener,
                                             public ButtonListener,
                                             public ComboBoxListener,
-                                            public Timer
+                                            public Timer,
+                                            public ScopeFeed::Client
 {
     friend class PluginAudioProcessor;
 public:
@@ -41,23 +84,36 @@ public:
     void buttonClicked(Button*);
     void buttonStateChanged(Button* button);
     void comboBoxChanged (ComboBox* comboBox);
+    
+    void feedScope (const float* samples, int numSamples);
 
 private:
     MidiKeyboardComponent midiKeyboard;
 
-    int scope_mode;
-    AudioOscilloscope *oscilloscope;
+    int scope_mode;                 // the analyser being shown (and fed)
+    bool bScopeVisible;             // whether the editor is wide enough to show the analysers
+    AudioOscilloscope *oscilloscope;    // (each created when first shown, owned by its panel)
     Spectroscope *spectrum;
     Sonogram *sonogram;
     TimeSliceThread scopeThread;
     
+    enum { kNumScopes = 3 };
+    ScopePanel scopePanels[kNumScopes];
     TabbedComponent tabScope;
     
+    void showScope(int mode);
+    
     Label infoLabel;
     
     Label label[kNumberOfControls];
     Component* controls[kNumberOfControls];
     
+    // the parameter set last shown by the controls
+    int iDisplayedEditChannel;
+    bool bDisplayedMultitimbral;
+    
+    Image background;               // the background gradient, drawn once per size
+    
     ScopedPointer<ResizableCornerComponent> resizer;
     ComponentBoundsConstrainer resizeLimits;
 
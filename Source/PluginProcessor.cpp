@@ -13,7 +13,12 @@ PluginAudioProcessor::PluginAudioProcessor()
     lastUIHeight = 320;
 
     lastPosInfo.resetToDefault();
+    
+    RealtimeSanitizer::install();
 
+    // the synth and its voices are created with this instance's context (and default sample rate)
+    const Context::Scope scope (context);
+    
     synth = createSynth();
     synth->addSound (new SimpleSound());
     
@@ -24,12 +29,20 @@ PluginAudioProcessor::PluginAudioProcessor()
         pVoice->setSynthesiser(reinterpret_cast<MySynth*>(synth));
         synth->addVoice (pVoice);   // These voices will play our custom sine-wave sounds..
     }
+    
+    // (tells the host about program changes made by the audio thread)
+    if (MessageManager::getInstanceWithoutCreating() != nullptr)
+        startTimer (100);
 }
 
 PluginAudioProcessor::~PluginAudioProcessor()
 {
+    const Context::Scope scope (context);
+    
     delete synth;
     synth = NULL;
+    
+    RealtimeSanitizer::checkForViolations();
 }
 
 //==============================================================================
@@ -43,7 +56,7 @@ float PluginAudioProcessor::getParameter (int index)
     // This method will be called by the host, probably on the audio thread, so
     // it's absolutely time-critical. Don't use critical sections or anything
     // UI-related, or anything at all that may block in any way!
-    return synth->getParameter(index);
+    return synth->getEditParameters().getParameter(index);
 }
 
 void PluginAudioProcessor::setParameter (int index, float newValue)
@@ -51,7 +64,7 @@ void PluginAudioProcessor::setParameter (int index, float newValue)
     // This method will be called by the host, probably on the audio thread, so
     // it's absolutely time-critical. Don't use critical sections or anything
     // UI-related, or anything at all that may block in any way!
-    synth->setParameter(index, newValue);
+    synth->getEditParameters().setParameter(index, newValue);
 }
 
 const String PluginAudioProcessor::getParameterName (int index)
@@ -64,24 +77,79 @@ const String PluginAudioProcessor::getParameterText (int index)
     return String (getParameter (index), 2);
 }
 
+void PluginAudioProcessor::setMultitimbral (bool shouldBeMultitimbral)
+{
+    synth->setMultitimbral(shouldBeMultitimbral);
+    updateHostDisplay();
+}
+
+void PluginAudioProcessor::setEditChannel (int midiChannel)
+{
+    synth->setEditChannel(midiChannel);
+    updateHostDisplay();
+}
+
 //==============================================================================
-void PluginAudioProcessor::prepareToPlay (double sampleRate, int /*samplesPerBlock*/)
+void PluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
+    context.prepare (sampleRate, samplesPerBlock);
+    const Context::Scope scope (context);
+    
     synth->setCurrentPlaybackSampleRate (sampleRate);
     keyboardState.reset();
     
-    stk::Stk::setSampleRate(sampleRate);
+    recorder.prepare (jmax (1, getNumOutputChannels()), sampleRate);
+    
+    bPrepared = 1;
 }
 
 void PluginAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    bPrepared = 0;
     keyboardState.reset();
 }
 
+//==============================================================================
+void PluginAudioProcessor::selectProgram (int index, float morphSeconds)
+{
+    if (bPrepared.get() != 0 && ! isSuspended())
+    {
+        // applied (or morphed to) by the next blocks, and the host told once it's finished
+        programs.select (index, morphSeconds);
+    }
+    else
+    {
+        // nothing is processing, so there's no block to wait for
+        programs.selectNow (index, synth->getEditParameters());
+        notifyHostOfParameters();
+    }
+}
+
+void PluginAudioProcessor::notifyHostOfParameters()
+{
+    // only the parameters that the program change altered
+    uint32 changed[ProgramBank<kNumberOfParameters>::kChangeWords];
+    
+    if (programs.takeChanges (changed))
+    {
+        for (int p = 0; p < getNumParameters(); ++p)
+            if (changed[p >> 5] & (1u << (p & 31)))
+                sendParamChangeMessageToListeners (p, getParameter (p));
+    }
+    
+    updateHostDisplay();
+}
+
+void PluginAudioProcessor::timerCallback()
+{
+    if (bProgramChanged.compareAndSetBool (0, 1))
+        notifyHostOfParameters();
+}
+
 void PluginAudioProcessor::reset()
 {
     // Use this method as the place to clear any delay lines, buffers, etc, as it
@@ -90,6 +158,15 @@ void PluginAudioProcessor::reset()
 
 void PluginAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
 {
+    // (debug builds) catch anything in here that isn't safe on the audio thread
+    const RealtimeSanitizer::ScopedRealtime realtime;
+    
+    // treat denormal floats as zero, so decaying tails don't cost more than the notes
+    const ScopedNoDenormals noDenormals;
+    
+    // the APDI and STK objects in the synth use this instance's sample rate and scratch memory
+    const Context::Scope scope (context);
+    
     const int numSamples = buffer.getNumSamples();
     
     // Pass any incoming midi messages to our keyboard state object, and let it
@@ -102,22 +179,35 @@ void PluginAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer&
     for (int i = getNumInputChannels(); i < getNumOutputChannels(); ++i)
         buffer.clear (i, 0, numSamples);
     
+    // apply any program change (or the next step of a morph) before rendering the block
+    // (the host is told about it from the timer, once it's finished)
+    if (programs.process (synth->getEditParameters(), numSamples, getSampleRate()))
+        bProgramChanged = 1;
+    
+    // in multitimbral mode, MIDI program changes select each channel's program
+    if (synth->isMultitimbral())
+    {
+        MidiBuffer::Iterator it (midiMessages);
+        MidiMessage message;
+        int position;
+        
+        while (it.getNextEvent (message, position))
+            if (message.isProgramChange())
+                programs.apply (message.getProgramChangeNumber(), synth->getChannelParameters (message.getChannel()));
+    }
+    
+    // scale the parameters for the voices
+    synth->updateParameters (numSamples);
+    
     // and now get the synth to process these midi events and generate its output.
     synth->renderNextBlock (buffer, midiMessages, 0, numSamples);
     synth->postProcess(buffer.getArrayOfChannels(), getNumOutputChannels(), numSamples);
     
-    if (getActiveEditor()){
-        PluginAudioProcessorEditor* editor = dynamic_cast<PluginAudioProcessorEditor*>(pEditor);
-
-        if(editor && editor->scope_mode & SCOPE_VISIBLE){
-            if(editor->oscilloscope && (editor->scope_mode & SCOPE_OSCILLOSCOPE))
-                editor->oscilloscope->processBlock(buffer.getSampleData(0), numSamples);
-            else if(editor->spectrum && (editor->scope_mode & SCOPE_SPECTRUM))
-                editor->spectrum->copySamples(buffer.getSampleData(0), numSamples);
-            else if(editor->sonogram)
-                editor->sonogram->copySamples(buffer.getSampleData(0), numSamples);
-        }
-    }
+    // copy the final output to the recorder (if it's recording)
+    recorder.process(buffer, numSamples);
+    
+    // pass the output to the editor's visible analyser (if there is one)
+    scopeFeed.process(buffer.getSampleData(0), numSamples);
     
     // ask the host for the current time so we can display it...
     AudioPlayHead::CurrentPositionInfo newTime;
@@ -141,38 +231,163 @@ AudioProcessorEditor* PluginAudioProcessor::createEditor()
 }
 
 //==============================================================================
-void PluginAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+// STATE - parameters are saved in a compact binary format:
+//
+//   StateHeader, then one StateParameter per parameter (in any order)
+//
+// The header records its own size, so newer versions can append fields to it
+// (older versions skip them, and find the parameter table after the header).
+// Version 1 headers end before the headerSize field, and the first version 2
+// headers before the editChannel field.
+//
+// Parameters are identified by a hash of their (sanitised) name, so states
+// still load after parameters are added, removed or reordered. States saved
+// in the older XML format are still read.
+//
+// In multitimbral mode, each MIDI channel's parameters follow, identified by
+// the parameter's hash offset by the channel (older versions skip these).
+
+static const uint32 STATE_MAGIC = ByteOrder::littleEndianInt("SYNS");
+static const uint32 STATE_VERSION = 2;
+static const uint32 STATE_CHANNEL_SALT = 0x9E3779B1;
+
+struct StateHeader
 {
-    // You should use this method to store your parameters in the memory block.
-    // Here's an example of how you can use XML to make it easy and more robust:
-
-    // Create an outer XML element..
-    XmlElement xml ("MYPLUGINSETTINGS");
+    uint32 magic;
+    uint32 version;
+    int32 uiWidth;
+    int32 uiHeight;
+    int32 numParameters;
+    uint32 headerSize;          // (version 2 on) the offset of the parameter table
+    int32 editChannel;          // the multitimbral edit channel (1-16)
+};
+
+static const uint32 STATE_HEADER_SIZE_V1 = 5 * sizeof (uint32);
+static const uint32 STATE_HEADER_SIZE_V2 = 6 * sizeof (uint32);
+
+struct StateParameter
+{
+    uint32 id;
+    float value;
+};
 
-    // add some attributes to it..
-    xml.setAttribute ("uiWidth", lastUIWidth);
-    xml.setAttribute ("uiHeight", lastUIHeight);
-    
-    for(int p=0; p<getNumParameters(); p++){
-        String name;
-        for (String::CharPointerType t (UI_CONTROLS[p].name.getCharPointer()); ! t.isEmpty(); ++t){
-            if(t.isLetterOrDigit() || *t == '_' || *t == '-' || *t == ':'){
-                name += *t;
+// Parameter names, stripped of any characters that aren't valid in XML attribute names
+// (computed once, rather than on every save and restore)
+struct ParameterIDs
+{
+    ParameterIDs() {
+        for(int p=0; p<kNumberOfParameters; p++){
+            for (CharPointer_UTF8 t (UI_CONTROLS[p].name); ! t.isEmpty(); ++t){
+                if(t.isLetterOrDigit() || *t == '_' || *t == '-' || *t == ':'){
+                    names[p] += *t;
+                }
             }
+            hashes[p] = (uint32) names[p].hashCode();
         }
-        xml.setAttribute(name, getParameter(p));
     }
+    
+    int indexOf(uint32 hash, int hint) const {
+        if(hint >= 0 && hint < kNumberOfParameters && hashes[hint] == hash)
+            return hint;
+        for(int p=0; p<kNumberOfParameters; p++)
+            if(hashes[p] == hash)
+                return p;
+        return -1;
+    }
+    
+    String names[kNumberOfParameters];
+    uint32 hashes[kNumberOfParameters];
+};
 
-    // then use this helper function to stuff it into the binary blob and return it..
-    copyXmlToBinary (xml, destData);
+static const ParameterIDs& getParameterIDs()
+{
+    static const ParameterIDs ids;
+    return ids;
 }
 
-void PluginAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+void PluginAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    const ParameterIDs& ids = getParameterIDs();
+    const int numChannels = synth->isMultitimbral() ? (int) Synth::kNumberOfMidiChannels : 0;
+    const int numParameters = getNumParameters() * (1 + numChannels);
+    
+    destData.setSize (sizeof (StateHeader) + sizeof (StateParameter) * numParameters, false);
+    
+    StateHeader* header = static_cast<StateHeader*> (destData.getData());
+    header->magic = ByteOrder::swapIfBigEndian (STATE_MAGIC);
+    header->version = ByteOrder::swapIfBigEndian (STATE_VERSION);
+    header->uiWidth = (int32) ByteOrder::swapIfBigEndian ((uint32) lastUIWidth);
+    header->uiHeight = (int32) ByteOrder::swapIfBigEndian ((uint32) lastUIHeight);
+    header->numParameters = (int32) ByteOrder::swapIfBigEndian ((uint32) numParameters);
+    header->headerSize = ByteOrder::swapIfBigEndian ((uint32) sizeof (StateHeader));
+    header->editChannel = (int32) ByteOrder::swapIfBigEndian ((uint32) synth->getEditChannel());
+    
+    StateParameter* parameter = reinterpret_cast<StateParameter*> (header + 1);
+    for(int c=0; c<=numChannels; c++){
+        // channel 0 is the synth's main set of parameters
+        IPluginParameters& parameters = c == 0 ? (IPluginParameters&) *synth : synth->getChannelParameters(c);
+        
+        for(int p=0; p<getNumParameters(); p++, parameter++){
+            parameter->id = ByteOrder::swapIfBigEndian (ids.hashes[p] + c * STATE_CHANNEL_SALT);
+            parameter->value = parameters.getParameter(p);
+           #if JUCE_BIG_ENDIAN
+            *reinterpret_cast<uint32*> (&parameter->value) = ByteOrder::swap (*reinterpret_cast<uint32*> (&parameter->value));
+           #endif
+        }
+    }
+}
 
-    // This getXmlFromBinary() helper function retrieves our XML from the binary blob..
+void PluginAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    const StateHeader* header = static_cast<const StateHeader*> (data);
+    
+    if (sizeInBytes >= (int) STATE_HEADER_SIZE_V1 && ByteOrder::swapIfBigEndian (header->magic) == STATE_MAGIC)
+    {
+        // the parameter table follows the header - whose size (from version 2 on) is stored in it
+        const uint32 version = ByteOrder::swapIfBigEndian (header->version);
+        if (version < 1 || (version >= 2 && sizeInBytes < (int) STATE_HEADER_SIZE_V2))
+            return;
+        
+        const uint32 headerSize = version == 1 ? STATE_HEADER_SIZE_V1 : ByteOrder::swapIfBigEndian (header->headerSize);
+        const uint32 minimumHeaderSize = version == 1 ? STATE_HEADER_SIZE_V1 : STATE_HEADER_SIZE_V2;
+        if (headerSize < minimumHeaderSize || headerSize > (uint32) sizeInBytes || (headerSize & 3) != 0)
+            return;
+        
+        const ParameterIDs& ids = getParameterIDs();
+        const int numParameters = jmin ((int) ByteOrder::swapIfBigEndian ((uint32) header->numParameters),
+                                        (sizeInBytes - (int) headerSize) / (int) sizeof (StateParameter));
+        
+        lastUIWidth  = (int) ByteOrder::swapIfBigEndian ((uint32) header->uiWidth);
+        lastUIHeight = (int) ByteOrder::swapIfBigEndian ((uint32) header->uiHeight);
+        
+        // the per-channel parameters (if any) switch on multitimbral mode
+        synth->setMultitimbral(false);
+        
+        const StateParameter* parameter = reinterpret_cast<const StateParameter*> (static_cast<const char*> (data) + headerSize);
+        for(int p=0; p<numParameters; p++, parameter++){
+            const uint32 id = ByteOrder::swapIfBigEndian (parameter->id);
+            float value = parameter->value;
+           #if JUCE_BIG_ENDIAN
+            *reinterpret_cast<uint32*> (&value) = ByteOrder::swap (*reinterpret_cast<uint32*> (&value));
+           #endif
+            
+            for(int c=0; c<=Synth::kNumberOfMidiChannels; c++){
+                const int index = ids.indexOf (id - c * STATE_CHANNEL_SALT, p % kNumberOfParameters);
+                if(index >= 0){
+                    if(c > 0)
+                        synth->setMultitimbral(true);
+                    (c == 0 ? (IPluginParameters&) *synth : synth->getChannelParameters(c)).setParameter(index, value);
+                    break;
+                }
+            }
+        }
+        
+        if (headerSize >= (uint32) sizeof (StateHeader))
+            synth->setEditChannel ((int) ByteOrder::swapIfBigEndian ((uint32) header->editChannel));
+        return;
+    }
+    
+    // Otherwise, this may be a state saved in the original XML format..
     ScopedPointer<XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
 
     if (xmlState != nullptr)
@@ -184,15 +399,9 @@ void PluginAudioProcessor::setStateInformation (const void* data, int sizeInByte
             lastUIWidth  = xmlState->getIntAttribute ("uiWidth", lastUIWidth);
             lastUIHeight = xmlState->getIntAttribute ("uiHeight", lastUIHeight);
 
-            for(int p=0; p<getNumParameters(); p++){
-                String name;
-                for (String::CharPointerType t (UI_CONTROLS[p].name.getCharPointer()); ! t.isEmpty(); ++t){
-                    if(t.isLetterOrDigit() || *t == '_' || *t == '-' || *t == ':'){
-                        name += *t;
-                    }
-                }
-                setParameter(p, (float) xmlState->getDoubleAttribute (name, getParameter(p)));
-            }
+            const ParameterIDs& ids = getParameterIDs();
+            for(int p=0; p<getNumParameters(); p++)
+                setParameter(p, (float) xmlState->getDoubleAttribute (ids.names[p], getParameter(p)));
         }
     }
 }
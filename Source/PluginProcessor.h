@@ -5,6 +5,9 @@
 #include "modules/stk_module/stk.h"
 
 #include "PluginWrapper.h"
+#include "PluginSanitizer.h"
+#include "PluginRecorder.h"
+#include "PluginConvolver.h"
 
 using namespace APDI;
 
@@ -12,14 +15,25 @@ using namespace APDI;
 
 #include "SynthEditor.h"
 
+// A set of parameters that can be set from any thread (the host's, the audio thread's or the
+// editor's), without locks. Each change is also marked in a bitset, which one reader (the
+// editor) drains with takeChanges() to update only the controls that have changed.
 template <int COUNT>
 class PluginParameters : public IPluginParameters
 {
 public:
+    enum { kChangeWords = (COUNT + 31) / 32 };  // the size of a takeChanges() bitset
+    
     PluginParameters() {
         // Set up some default values..
-        for(int p=0; p<COUNT; p++)
+        for(int p=0; p<COUNT; p++){
             parameters[p] = 0.0f;
+            updated[p] = 0.0f;
+            targets[p] = values[p] = UI_CONTROLS[p].scale(0.0f);
+        }
+        for(int w=0; w<kChangeWords; w++)
+            changes[w] = 0;
+        bSmoothing = false;
     }
     
     //==============================================================================
@@ -31,14 +45,56 @@ public:
     float getParameter (int index) const
     {
         if(index >= 0 && index < COUNT)
-            return parameters[index];
+            return parameters[index].get();
         return 0.0f;
     }
     
     void setParameter (int index, float newValue)
     {
-        if(index >= 0 && index < COUNT)
+        if(index >= 0 && index < COUNT && parameters[index].get() != newValue){
             parameters[index] = newValue;
+            markChanged(index);
+        }
+    }
+    
+    // the value as the voices see it (see update())
+    float getValue (int index) const
+    {
+        if(index >= 0 && index < COUNT)
+            return values[index];
+        return 0.0f;
+    }
+    
+    // Scales (and smooths) the parameters for the voices' next block (on the audio thread). Each
+    // value is only rescaled when the parameter changes.
+    void update (int numSamples)
+    {
+        const float sampleRate = (float) getSampleRate();
+        
+        for(int p=0; p<COUNT; p++){
+            const float parameter = parameters[p].get();
+            if(parameter != updated[p]){
+                updated[p] = parameter;
+                targets[p] = UI_CONTROLS[p].scale(parameter);
+            }
+            
+            if(values[p] != targets[p]){
+                // (glide until within 1/100000th of the range)
+                const Scale& scale = UI_CONTROLS[p].scale;
+                if(bSmoothing && scale.smoothing > 0.0f && std::abs(targets[p] - values[p]) > 1.0e-5f * std::abs(scale.to - scale.from))
+                    values[p] += (targets[p] - values[p]) * (1.0f - std::exp(-numSamples / (scale.smoothing * sampleRate)));
+                else
+                    values[p] = targets[p];
+            }
+        }
+        bSmoothing = true; // (the first values are set at once)
+    }
+    
+    // Scales the parameters at once, without smoothing (only while the audio thread isn't using them)
+    void updateAtOnce()
+    {
+        bSmoothing = false;
+        update(0);
     }
     
     const String getParameterName (int index) const
@@ -52,30 +108,172 @@ public:
     {
         return String (getParameter (index), 2);
     }
+    
+    // Fills the bitset (of kChangeWords words) with the parameters that have changed since the
+    // last call, and clears them, returning false if none have
+    bool takeChanges (uint32* changed)
+    {
+        uint32 any = 0;
+        for(int w=0; w<kChangeWords; w++)
+            any |= changed[w] = changes[w].exchange(0);
+        return any != 0;
+    }
+    
+    // the whole block of parameters at once (e.g. for program changes)
+    void getParameters (float* values) const
+    {
+        for(int p=0; p<COUNT; p++)
+            values[p] = parameters[p].get();
+    }
+    void setParameters (const float* values)
+    {
+        for(int p=0; p<COUNT; p++){
+            if(parameters[p].get() != values[p]){
+                parameters[p] = values[p];
+                markChanged(p);
+            }
+        }
+    }
+    
 private:
-    float parameters[COUNT];
+    void markChanged (int index)
+    {
+        Atomic<uint32>& word = changes[index >> 5];
+        const uint32 bit = 1u << (index & 31);
+        uint32 old;
+        do {
+            old = word.get();
+        } while(!(old & bit) && !word.compareAndSetBool(old | bit, old));
+    }
+    
+    Atomic<float> parameters[COUNT];
+    Atomic<uint32> changes[kChangeWords];
+    
+    // audio thread state - the voices' values, their targets, and the parameters they are for
+    float values[COUNT];
+    float targets[COUNT];
+    float updated[COUNT];
+    bool bSmoothing;
 };
 
 class Synth : public Synthesiser, public PluginParameters<kNumberOfParameters> {
 public:
-    Synth() : Synthesiser() {
-        SAMPLE_RATE = 44100.0; // sample rate potentially not valid before playback
-        
+    enum { kNumberOfMidiChannels = 16 };
+    
+    Synth() : Synthesiser(), bMultitimbral(0), iEditChannel(1) {
         for(int p=0; p<kNumberOfParameters; p++)
             setParameter(p, UI_CONTROLS[p].initial);
     }
     
     virtual void postProcess(float** outputBuffer, int numChannels, int numSamples) {}
     
-    void setCurrentPlaybackSampleRate (const double newRate){
-        Synthesiser::setCurrentPlaybackSampleRate(SAMPLE_RATE = newRate);
+    // Multitimbral mode - each MIDI channel plays with its own copy of the parameters,
+    // while all channels share the same voices (one SimpleSound per channel selects them)
+    // (called from the message or host thread - the audio thread sees the channels' parameters
+    // once they're ready, when the flag is set)
+    void setMultitimbral(bool shouldBeMultitimbral) {
+        if(shouldBeMultitimbral == isMultitimbral())
+            return;
+        
+        allNotesOff(0, false);
+        clearSounds();
+        
+        if(shouldBeMultitimbral){
+            float values[kNumberOfParameters];
+            getParameters(values);
+            for(int c=0; c<kNumberOfMidiChannels; c++){
+                channelParameters[c].setParameters(values);
+                channelParameters[c].updateAtOnce();
+                addSound(new SimpleSound(c + 1, &channelParameters[c]));
+            }
+        }else{
+            addSound(new SimpleSound(0, this));
+        }
+        
+        bMultitimbral = shouldBeMultitimbral ? 1 : 0;
+    }
+    
+    bool isMultitimbral() const { return bMultitimbral.get() != 0; }
+    
+    // The parameters used by a MIDI channel (1-16)
+    PluginParameters<kNumberOfParameters>& getChannelParameters(int midiChannel) {
+        if(isMultitimbral() && midiChannel >= 1 && midiChannel <= kNumberOfMidiChannels)
+            return channelParameters[midiChannel - 1];
+        return *this;
+    }
+    
+    // The channel whose parameters are shown to the host and editor in multitimbral mode
+    void setEditChannel(int midiChannel) { iEditChannel = jlimit(1, (int) kNumberOfMidiChannels, midiChannel); }
+    int getEditChannel() const { return iEditChannel.get(); }
+    
+    PluginParameters<kNumberOfParameters>& getEditParameters() { return getChannelParameters(getEditChannel()); }
+    
+    // Scales the parameters for the voices' next block (see PluginParameters::update)
+    void updateParameters(int numSamples) {
+        update(numSamples);
+        if(isMultitimbral())
+            for(int c=0; c<kNumberOfMidiChannels; c++)
+                channelParameters[c].update(numSamples);
+    }
+    
+private:
+    PluginParameters<kNumberOfParameters> channelParameters[kNumberOfMidiChannels];
+    Atomic<int> bMultitimbral;
+    Atomic<int> iEditChannel;
+};
+
+#include "PluginPrograms.h"
+
+//==============================================================================
+/** Passes the plugin's output to the analyser the editor is showing (if any). The editor
+    connects a client on the message thread whenever it shows a different analyser, and
+    disconnects it when hidden, so processBlock feeds the client without locking, and a
+    closed, hidden or minimised editor costs the audio thread only one atomic read. */
+class ScopeFeed
+{
+public:
+    class Client
+    {
+    public:
+        virtual ~Client() {}
+        virtual void feedScope (const float* samples, int numSamples) = 0;    // (audio thread)
+    };
+    
+    ScopeFeed() : client (nullptr) {}
+    
+    // (message thread) replaces the client (or disconnects it, with NULL), only returning
+    // once the audio thread has finished with any previous client
+    void connect (Client* newClient)
+    {
+        client.set (newClient);
+        Atomic<int>::memoryBarrier();
+        
+        while (busy.get() != 0)
+            Thread::yield();
+    }
+    
+    // (audio thread)
+    void process (const float* samples, int numSamples)
+    {
+        if (client.get() == nullptr)
+            return;
+        
+        ++busy;
+        if (Client* const c = client.get())
+            c->feedScope (samples, numSamples);
+        --busy;
     }
+    
+private:
+    Atomic<Client*> client;
+    Atomic<int> busy;
 };
 
 //==============================================================================
 /**
 */
-class PluginAudioProcessor  : public AudioProcessor //, public IPluginParameters
+class PluginAudioProcessor  : public AudioProcessor, //, public IPluginParameters
+                              private Timer
 {
     friend class PluginAudioProcessorEditor;
 public:
@@ -109,15 +307,37 @@ public:
     int getNumParameters();
     float getParameter (int index);
     void setParameter (int index, float newValue);
+    // Fills the bitset with the edited parameters that have changed since the last call (for the editor)
+    bool takeParameterChanges (uint32* changed)                         { return synth->getEditParameters().takeChanges(changed); }
     const String getParameterName (int index);
     const String getParameterText (int index);
 
     //==============================================================================
-    int getNumPrograms()                                                { return 0; }
-    int getCurrentProgram()                                             { return 0; }
-    void setCurrentProgram (int /*index*/)                              { }
-    const String getProgramName (int /*index*/)                         { return String::empty; }
-    void changeProgramName (int /*index*/, const String& /*newName*/)   { }
+    int getNumPrograms()                                                { return programs.getNumPrograms(); }
+    int getCurrentProgram()                                             { return programs.getCurrentProgram(); }
+    void setCurrentProgram (int index)                                  { selectProgram (index, 0.0f); }
+    const String getProgramName (int index)                             { return programs.getName (index); }
+    void changeProgramName (int index, const String& newName)           { programs.setName (index, newName); }
+    
+    // Moves smoothly from the current settings to a program, over the given time
+    void morphToProgram (int index, float seconds)                      { selectProgram (index, seconds); }
+    
+    //==============================================================================
+    // In multitimbral mode, each MIDI channel has its own parameters (and responds to program
+    // changes), and the plugin's parameters are those of the edit channel
+    void setMultitimbral (bool shouldBeMultitimbral);
+    bool isMultitimbral() const                                         { return synth->isMultitimbral(); }
+    
+    void setEditChannel (int midiChannel);
+    int getEditChannel() const                                          { return synth->getEditChannel(); }
+
+    //==============================================================================
+    // Records the plugin's output to a file (.wav, .flac or .aiff) - not for the audio thread
+    Result startRecording (const File& file)                            { return recorder.startRecording (file); }
+    void stopRecording()                                                { recorder.stopRecording(); }
+    bool isRecording() const                                            { return recorder.isRecording(); }
+    
+    const Recorder& getRecorder() const                                 { return recorder; }
 
     //==============================================================================
     void getStateInformation (juce::MemoryBlock& destData);
@@ -137,11 +357,28 @@ public:
     int lastUIWidth, lastUIHeight;
     
     void onButtonClicked(int control) {}
+    
+    // The sample rate, block size and scratch memory of this instance (see PluginContext.h)
+    Context& getContext()                                               { return context; }
+    
+    // Feeds the output to the editor's analysers
+    ScopeFeed& getScopeFeed()                                           { return scopeFeed; }
 
 private:
+    void selectProgram (int index, float morphSeconds);
+    void notifyHostOfParameters();
+    void timerCallback();
+    
     AudioProcessorEditor* pEditor;
     
+    Atomic<int> bPrepared;              // between prepareToPlay and releaseResources
+    Atomic<int> bProgramChanged;        // set by the audio thread when a program change has finished
+    
+    Context context;
     Synth* synth;
+    ProgramBank<kNumberOfParameters> programs;
+    Recorder recorder;
+    ScopeFeed scopeFeed;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginAudioProcessor)
 };
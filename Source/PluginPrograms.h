@@ -0,0 +1,198 @@
+//
+//  PluginPrograms.h
+//  SynthPlugin
+//
+//  The plugin's program (preset) bank. Programs are held in memory as complete
+//  parameter snapshots, built at startup from the initial values in UI_CONTROLS
+//  and the presets in UI_PRESETS (see SynthEditor.h).
+//
+//  While the plugin is processing, program changes are requested from any thread,
+//  but only applied by the audio thread at the start of a block, so a whole
+//  snapshot is switched at once. They can also be morphed over time, interpolating
+//  the continuous parameters once per block (switches and menus change at the end).
+//  While it isn't, they're applied at once.
+//
+//  The parameters that a finished change has altered are marked in a bitset, which
+//  the processor drains with takeChanges() to tell the host about them.
+//
+
+#ifndef _PluginPrograms_h_
+#define _PluginPrograms_h_
+
+template <int COUNT>
+class ProgramBank
+{
+public:
+    struct Program
+    {
+        String name;
+        float values[COUNT];
+    };
+
+    enum { kChangeWords = (COUNT + 31) / 32 };  // the size of a takeChanges() bitset
+
+    ProgramBank()
+    :   current(0), morphLength(0), morphPosition(0), bMorphing(false), pendingRequest(-1)
+    {
+        for(int p=0; p<COUNT; p++)
+            bContinuous[p] = UI_CONTROLS[p].type == ROTARY || UI_CONTROLS[p].type == SLIDER;
+        for(int w=0; w<kChangeWords; w++)
+            changes[w] = 0;
+
+        Program* program = programs.add(new Program());
+        program->name = "Default";
+        for(int p=0; p<COUNT; p++)
+            program->values[p] = UI_CONTROLS[p].initial;
+
+        for(int i=0; i<kNumberOfPresets; i++){
+            program = programs.add(new Program());
+            program->name = UI_PRESETS[i].name;
+            FloatVectorOperations::copy(program->values, UI_PRESETS[i].values, COUNT);
+        }
+    }
+
+    int getNumPrograms() const { return programs.size(); }
+    int getCurrentProgram() const { return current.get(); }
+
+    const String getName(int index) const {
+        return isPositiveAndBelow(index, programs.size()) ? programs[index]->name : String::empty;
+    }
+
+    void setName(int index, const String& name) {
+        if(isPositiveAndBelow(index, programs.size()))
+            programs[index]->name = name;
+    }
+
+    // Requests a program change, morphing from the current settings over the given time
+    // (applied at the start of the next audio block)
+    void select(int index, float morphSeconds = 0.0f) {
+        if(isPositiveAndBelow(index, programs.size())){
+            // (the program and time are published together, so they're always read together)
+            FloatBits time;
+            time.f = jmax(0.0f, morphSeconds);
+            pendingRequest.set(((int64) index << 32) | (int64) (uint32) time.i);
+            current.set(index);
+        }
+    }
+
+    // Switches to a program at once (only while the audio thread isn't processing)
+    void selectNow(int index, PluginParameters<COUNT>& parameters) {
+        if(isPositiveAndBelow(index, programs.size())){
+            pendingRequest.set(-1);
+            if(!bMorphing)
+                parameters.getParameters(morphStart);
+            bMorphing = false;
+            parameters.setParameters(programs[index]->values);
+            markChanges(morphStart, programs[index]->values);
+            current.set(index);
+        }
+    }
+
+    // Called by the audio thread before each block is rendered (returns true when a program
+    // change has finished - at once, or at the end of a morph)
+    bool process(PluginParameters<COUNT>& parameters, int numSamples, double sampleRate) {
+        const int64 request = pendingRequest.exchange(-1);
+
+        if(request >= 0){
+            const int program = (int) (request >> 32);
+            FloatBits time;
+            time.i = (int32) (request & 0xffffffff);
+            const int length = (int) (time.f * sampleRate);
+
+            // compare with the settings before any morph that this one interrupts
+            if(!bMorphing)
+                parameters.getParameters(morphStart);
+
+            if(length <= numSamples){
+                parameters.setParameters(programs[program]->values);
+                markChanges(morphStart, programs[program]->values);
+                bMorphing = false;
+                return true;
+            }
+
+            // morph from wherever we are now (even part-way through another morph)
+            parameters.getParameters(morphFrom);
+            FloatVectorOperations::copy(morphTo, programs[program]->values, COUNT);
+            morphLength = length;
+            morphPosition = 0;
+            bMorphing = true;
+        }
+
+        if(bMorphing){
+            morphPosition = jmin(morphPosition + numSamples, morphLength);
+            const float amount = (float) morphPosition / morphLength;
+
+            if(morphPosition >= morphLength){
+                parameters.setParameters(morphTo); // land exactly on the target
+                markChanges(morphStart, morphTo);
+                bMorphing = false;
+                return true;
+            }
+
+            // (switches and menus keep their settings until the end)
+            for(int p=0; p<COUNT; p++)
+                morphValues[p] = bContinuous[p] ? morphFrom[p] + (morphTo[p] - morphFrom[p]) * amount : morphFrom[p];
+            parameters.setParameters(morphValues);
+        }
+        
+        return false;
+    }
+
+    // Fills the bitset (of kChangeWords words) with the parameters that finished program changes
+    // have altered since the last call, and clears them, returning false if none have
+    bool takeChanges(uint32* changed) {
+        uint32 any = 0;
+        for(int w=0; w<kChangeWords; w++)
+            any |= changed[w] = changes[w].exchange(0);
+        return any != 0;
+    }
+
+    bool isMorphing() const { return bMorphing; }
+
+    // Copies a program's settings straight into a set of parameters (e.g. for one MIDI channel)
+    void apply(int index, PluginParameters<COUNT>& parameters) const {
+        if(isPositiveAndBelow(index, programs.size()))
+            parameters.setParameters(programs[index]->values);
+    }
+
+private:
+    union FloatBits
+    {
+        float f;
+        int32 i;
+    };
+
+    void markChanges(const float* from, const float* to) {
+        for(int w=0; w<kChangeWords; w++){
+            uint32 bits = 0;
+            for(int p=w*32; p<jmin(COUNT, w*32+32); p++)
+                if(from[p] != to[p])
+                    bits |= 1u << (p & 31);
+
+            uint32 old;
+            do {
+                old = changes[w].get();
+            } while((old | bits) != old && !changes[w].compareAndSetBool(old | bits, old));
+        }
+    }
+
+    OwnedArray<Program> programs;
+    bool bContinuous[COUNT];            // ROTARY and SLIDER parameters are interpolated by morphs
+    Atomic<int> current;
+
+    // audio thread state
+    float morphStart[COUNT];            // the settings before the change (or chain of morphs)
+    float morphFrom[COUNT];
+    float morphTo[COUNT];
+    float morphValues[COUNT];
+    int morphLength, morphPosition;
+    bool bMorphing;
+
+    // requests from other threads: the program index (high word) and morph time (float bits), or -1
+    Atomic<int64> pendingRequest;
+    Atomic<uint32> changes[kChangeWords];
+
+    JUCE_DECLARE_NON_COPYABLE (ProgramBank)
+};
+
+#endif
@@ -0,0 +1,210 @@
+//
+//  PluginRecorder.h
+//  SynthPlugin
+//
+//  Records the plugin's output to disk (as WAV, FLAC or AIFF), without ever
+//  blocking the audio thread - unlike stk::FileWvOut, which writes the file in
+//  tick(). Each block is copied into a lock-free FIFO, which a background thread
+//  passes on to an AudioFormatWriter::ThreadedWriter for encoding and writing.
+//
+//  All memory is allocated up front, within a fixed budget. If the disk falls so
+//  far behind that the FIFO fills, blocks are dropped (and counted) rather than
+//  waiting for it.
+//
+
+#ifndef _PluginRecorder_h_
+#define _PluginRecorder_h_
+
+namespace APDI
+{
+
+class Recorder : private TimeSliceClient
+{
+public:
+    enum { DEFAULT_MEMORY_BUDGET = 8 * 1024 * 1024 }; // bytes (~20s of stereo at 44.1kHz)
+    enum { MAX_WRITE_SIZE = 4096 };                     // samples passed to the writer at a time
+
+    Recorder(int memoryBudget = DEFAULT_MEMORY_BUDGET)
+    :   thread("Recording Thread"), fifo(1), buffer(1, 1), iMemoryBudget(memoryBudget),
+        iNumChannels(0), fSampleRate(0.0), iWriterSize(0)
+    {
+        thread.addTimeSliceClient(this);
+    }
+
+    ~Recorder() {
+        stopRecording();
+        thread.removeTimeSliceClient(this);
+        thread.stopThread(2000);
+    }
+
+    // Allocates the buffers for the output format (not on the audio thread, or while it's running).
+    // A recording in progress is stopped if the format changes.
+    void prepare(int numChannels, double sampleRate) {
+        if(numChannels == iNumChannels && sampleRate == fSampleRate)
+            return;
+
+        stopRecording();
+
+        const ScopedLock lock(writerLock);
+
+        // three quarters of the budget for the FIFO, the rest for the writer's own buffer
+        const int numSamples = iMemoryBudget / (jmax(1, numChannels) * (int) sizeof(float));
+        buffer.setSize(numChannels, numSamples * 3 / 4);
+        fifo.setTotalSize(numSamples * 3 / 4);
+        fifo.reset();
+        channels.malloc(numChannels);
+
+        iNumChannels = numChannels;
+        fSampleRate = sampleRate;
+        iWriterSize = numSamples / 4;
+    }
+
+    //==========================================================================
+    // Starts recording to a file, replacing it (not on the audio thread)
+    Result startRecording(const File& file, int bitsPerSample = 24) {
+        stopRecording();
+
+        if(iNumChannels == 0)
+            return Result::fail("The recorder has not been prepared");
+
+        AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        AudioFormat* format = formats.findFormatForFileExtension(file.getFileExtension());
+        if(format == nullptr)
+            return Result::fail("Unsupported file format: " + file.getFileName());
+
+        file.deleteFile();
+        ScopedPointer<FileOutputStream> out (file.createOutputStream());
+        AudioFormatWriter* writer = out != nullptr ? format->createWriterFor(out, fSampleRate, iNumChannels, bitsPerSample, StringPairArray(), 0)
+                                                   : NULL;
+        if(writer == nullptr)
+            return Result::fail("Couldn't write " + file.getFullPathName());
+        out.release(); // now owned by the writer
+
+        if(!thread.isThreadRunning())
+            thread.startThread(6); // above normal, so the FIFO drains promptly
+
+        {
+            const ScopedLock lock(writerLock);
+            discard();
+            threadedWriter = new AudioFormatWriter::ThreadedWriter(writer, thread, iWriterSize);
+        }
+
+        overruns.set(0);
+        droppedSamples.set(0);
+        peakReady.set(0);
+        bRecording.set(1);
+        return Result::ok();
+    }
+
+    // Stops recording, once everything recorded so far is written to the file (not on the audio thread)
+    void stopRecording() {
+        if(!bRecording.exchange(0))
+            return;
+
+        const ScopedLock lock(writerLock);
+        while(drain() == false)
+            Thread::sleep(1); // the writer is full - wait for the thread to catch up
+        threadedWriter = nullptr;
+    }
+
+    bool isRecording() const { return bRecording.get() != 0; }
+
+    //==========================================================================
+    // Called by the audio thread with each block of output
+    void process(const AudioSampleBuffer& source, int numSamples) {
+        if(!bRecording.get())
+            return;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+        if(size1 + size2 < numSamples){
+            // the disk isn't keeping up - drop this block
+            ++overruns;
+            droppedSamples += numSamples;
+            return;
+        }
+
+        for(int c=0; c<iNumChannels; c++){
+            const int channel = jmin(c, source.getNumChannels() - 1);
+            buffer.copyFrom(c, start1, source, channel, 0, size1);
+            if(size2 > 0)
+                buffer.copyFrom(c, start2, source, channel, size1, size2);
+        }
+        fifo.finishedWrite(numSamples);
+
+        const int ready = fifo.getNumReady();
+        if(ready > peakReady.get())
+            peakReady.set(ready);
+    }
+
+    //==========================================================================
+    // The number of blocks (and samples) dropped since recording started
+    int getNumOverruns() const { return overruns.get(); }
+    int getNumDroppedSamples() const { return droppedSamples.get(); }
+
+    // How full the FIFO is now, and the most it has been since recording started (0 to 1)
+    float getFillLevel() const { return (float) fifo.getNumReady() / fifo.getTotalSize(); }
+    float getPeakFillLevel() const { return (float) peakReady.get() / fifo.getTotalSize(); }
+
+private:
+    int useTimeSlice() {
+        // (never waits, as the writer's buffer is serviced by this same thread)
+        const ScopedTryLock lock(writerLock);
+        if(!lock.isLocked())
+            return 1;
+
+        if(threadedWriter == nullptr){
+            discard();
+            return 20;
+        }
+
+        return drain() ? 5 : 1;
+    }
+
+    // Passes what's in the FIFO to the writer (returns false if it can't take it all yet)
+    bool drain() {
+        while(fifo.getNumReady() > 0){
+            int start1, size1, start2, size2;
+            fifo.prepareToRead(jmin(fifo.getNumReady(), (int) MAX_WRITE_SIZE), start1, size1, start2, size2);
+
+            for(int c=0; c<iNumChannels; c++)
+                channels[c] = buffer.getSampleData(c, start1);
+
+            if(!threadedWriter->write(channels, size1))
+                return false;
+
+            fifo.finishedRead(size1);
+        }
+        return true;
+    }
+
+    void discard() {
+        fifo.finishedRead(fifo.getNumReady());
+    }
+
+    TimeSliceThread thread;
+
+    AbstractFifo fifo;
+    AudioSampleBuffer buffer;
+    HeapBlock<const float*> channels;
+
+    int iMemoryBudget;
+    int iNumChannels;
+    double fSampleRate;
+    int iWriterSize;
+
+    ScopedPointer<AudioFormatWriter::ThreadedWriter> threadedWriter;
+    CriticalSection writerLock;
+
+    Atomic<int> bRecording;
+    Atomic<int> overruns, droppedSamples, peakReady;
+
+    JUCE_DECLARE_NON_COPYABLE (Recorder)
+};
+
+} // namespace APDI
+
+#endif
@@ -0,0 +1,430 @@
+//
+//  PluginRegression.cpp
+//  SynthPlugin
+//
+//  The regression harness for the synth's output (see PluginRegression.h).
+//
+
+#include "PluginRegression.h"
+#include "PluginBatch.h"
+
+#include <ctime>
+
+namespace APDI
+{
+
+namespace
+{
+    enum { kGoldenVersion = 1 };
+
+    struct GoldenHeader
+    {
+        char magic[4];          // "APDG"
+        int32 version;
+        int32 channels;
+        int32 samples;
+        float sampleRate;
+        int32 reserved;
+    };
+
+    // spectral comparison
+    enum { kFFTSizeLog2 = 11, kFFTSize = 1 << kFFTSizeLog2 };
+    const float kMagnitudeFloor = 1.0e-5f;  // (-100dB) stops silence dominating the distance
+
+    Regression::Scene* addScene(OwnedArray<Regression::Scene>& scenes, const String& name, int program,
+                                double seconds, Regression::Mode mode, double tolerance)
+    {
+        Regression::Scene* scene = scenes.add(new Regression::Scene());
+        scene->name = name;
+        scene->program = program;
+        scene->seconds = seconds;
+        scene->mode = mode;
+        scene->tolerance = tolerance;
+        return scene;
+    }
+
+    struct FileNameComparator
+    {
+        static int compareElements(const File& a, const File& b) { return a.getFileName().compare(b.getFileName()); }
+    };
+
+    void addNote(MidiMessageSequence& sequence, int note, float velocity, double start, double length, int channel = 1)
+    {
+        sequence.addEvent(MidiMessage::noteOn(channel, note, velocity), start);
+        sequence.addEvent(MidiMessage::noteOff(channel, note), start + length);
+    }
+}
+
+//==============================================================================
+void Regression::addBuiltInScenes(OwnedArray<Scene>& scenes)
+{
+    // a single note, to isolate the voice
+    addNote(addScene(scenes, "Single Note", 0, 2.0, kExact, 0.0)->sequence, 60, 0.8f, 0.0, 1.0);
+
+    // a chord, to exercise the mixing of voices
+    {
+        MidiMessageSequence& sequence = addScene(scenes, "Chord", 0, 2.5, kExact, 0.0)->sequence;
+        const int notes[] = { 48, 55, 60, 64, 67 };
+        for(int n=0; n<numElementsInArray(notes); n++)
+            addNote(sequence, notes[n], 0.5f + 0.1f * n, 0.0, 1.5);
+    }
+
+    // a fast arpeggio over the keyboard, with overlapping releases
+    {
+        MidiMessageSequence& sequence = addScene(scenes, "Arpeggio", 0, 4.0, kMaxAbs, 1.0e-6)->sequence;
+        for(int n=0; n<24; n++)
+            addNote(sequence, 36 + (n * 7) % 60, 0.4f + 0.025f * n, n * 0.125, 0.25);
+    }
+
+    // pitch wheel and controller movements during a held note
+    {
+        MidiMessageSequence& sequence = addScene(scenes, "Pitch Wheel And CC", 0, 3.0, kMaxAbs, 1.0e-6)->sequence;
+        addNote(sequence, 57, 0.7f, 0.0, 2.5);
+        for(int s=0; s<=40; s++){
+            const double time = 0.05 * s;
+            sequence.addEvent(MidiMessage::pitchWheel(1, 8192 + (int) (4000.0 * std::sin(s * 0.3))), time);
+            sequence.addEvent(MidiMessage::controllerEvent(1, 1, (s * 3) % 128), time);
+        }
+    }
+
+    // another program, to cover its settings
+    addNote(addScene(scenes, "Program 2", 1, 2.0, kSpectral, 0.5)->sequence, 64, 0.8f, 0.0, 1.0);
+
+    // more notes than voices, to exercise voice stealing
+    {
+        MidiMessageSequence& sequence = addScene(scenes, "Voice Stealing", 0, 4.0, kSpectral, 1.0)->sequence;
+        for(int n=0; n<40; n++)
+            addNote(sequence, 30 + n * 2, 0.6f, n * 0.05, 2.0);
+    }
+
+    for(int s=0; s<scenes.size(); s++)
+        scenes[s]->sequence.updateMatchedPairs();
+}
+
+void Regression::addScenesFromFolder(OwnedArray<Scene>& scenes, const File& folder, Mode mode, double tolerance)
+{
+    Array<File> files;
+    folder.findChildFiles(files, File::findFiles, false, "*.mid;*.midi");
+    FileNameComparator comparator;
+    files.sort(comparator);
+
+    for(int f=0; f<files.size(); f++){
+        MidiFile midiFile;
+        {
+            FileInputStream in (files[f]);
+            if(in.failedToOpen() || !midiFile.readFrom(in))
+                continue;
+        }
+        midiFile.convertTimestampTicksToSeconds();
+
+        Scene* scene = addScene(scenes, files[f].getFileNameWithoutExtension(), 0, 0.0, mode, tolerance);
+        for(int t=0; t<midiFile.getNumTracks(); t++)
+            scene->sequence.addSequence(*midiFile.getTrack(t), 0.0, 0.0, midiFile.getLastTimestamp() + 1.0);
+        scene->seconds = scene->sequence.getEndTime() + 2.0;
+    }
+}
+
+//==============================================================================
+double Regression::render(const Scene& scene, AudioSampleBuffer& output)
+{
+    const int length = (int) (scene.seconds * kSampleRate);
+    output.setSize(kNumberOfChannels, length);
+
+    ScopedPointer<PluginAudioProcessor> processor (new PluginAudioProcessor());
+    processor->setNonRealtime(true);
+    processor->setPlayConfigDetails(0, kNumberOfChannels, kSampleRate, kBlockSize);
+    processor->prepareToPlay(kSampleRate, kBlockSize);
+
+    if(scene.program < processor->getNumPrograms())
+        processor->setCurrentProgram(scene.program);
+
+    AudioSampleBuffer block (kNumberOfChannels, kBlockSize);
+    MidiBuffer midi;
+    int event = 0;
+
+    // (only the rendering is timed, not the set up)
+    const std::clock_t start = std::clock();
+
+    for(int position = 0; position < length; position += kBlockSize){
+        const int numSamples = jmin((int) kBlockSize, length - position);
+
+        block.setSize(kNumberOfChannels, numSamples, false, false, true);
+        BatchRenderer::renderNextBlock(*processor, scene.sequence, event, position, kSampleRate, block, midi);
+
+        for(int c=0; c<kNumberOfChannels; c++)
+            output.copyFrom(c, position, block, c, 0, numSamples);
+    }
+
+    const double cpuSeconds = (double) (std::clock() - start) / CLOCKS_PER_SEC;
+
+    processor->releaseResources();
+    return cpuSeconds;
+}
+
+Regression::Outcome Regression::run(const Scene& scene, const File& goldenFolder, bool updateGolden)
+{
+    Outcome outcome;
+    outcome.bPassed = outcome.bRecorded = false;
+    outcome.error = 0.0;
+    outcome.audioSeconds = scene.seconds;
+
+    Mode mode = scene.mode;
+    getModeOverride(mode);
+
+    AudioSampleBuffer output (kNumberOfChannels, 1);
+    outcome.cpuSeconds = render(scene, output);
+
+    const File golden (goldenFolder.getChildFile(File::createLegalFileName(scene.name) + ".apdg"));
+    const String timing (String(outcome.cpuSeconds * 1000.0, 1) + "ms for " + String(scene.seconds, 1) + "s");
+
+    if(updateGolden || !golden.existsAsFile()){
+        outcome.bRecorded = outcome.bPassed = saveGolden(golden, output);
+        outcome.message = outcome.bPassed ? "recorded " + golden.getFileName() + " (" + timing + ")"
+                                          : "couldn't write " + golden.getFullPathName();
+    }else{
+        AudioSampleBuffer expected (kNumberOfChannels, 1);
+        if(!loadGolden(golden, expected)){
+            outcome.message = "couldn't read " + golden.getFullPathName();
+            return outcome;
+        }
+
+        outcome.error = compare(output, expected, mode);
+        if(outcome.error < 0.0){
+            outcome.message = "the render's length differs from " + golden.getFileName();
+        }else{
+            outcome.bPassed = mode == kExact ? outcome.error == 0.0 : outcome.error <= scene.tolerance;
+            outcome.message = getModeName(mode) + " error " + String(outcome.error, 8)
+                            + (mode == kExact ? String::empty : " (tolerance " + String(scene.tolerance, 8) + ")")
+                            + ", " + timing;
+        }
+    }
+
+    // (a CSV, so the timings of successive runs can be compared)
+    const File timings (goldenFolder.getChildFile("timings.csv"));
+    const bool bNewFile = !timings.existsAsFile();
+    FileOutputStream out (timings);
+    if(out.openedOk()){
+        if(bNewFile)
+            out << "time,scene,mode,error,passed,cpu seconds,audio seconds" << newLine;
+        out << Time::getCurrentTime().formatted("%Y-%m-%d %H:%M:%S") << "," << scene.name << "," << getModeName(mode) << ","
+            << String(outcome.error, 8) << "," << (outcome.bPassed ? "1" : "0") << ","
+            << String(outcome.cpuSeconds, 4) << "," << String(outcome.audioSeconds, 3) << newLine;
+    }
+
+    return outcome;
+}
+
+//==============================================================================
+double Regression::compare(const AudioSampleBuffer& render, const AudioSampleBuffer& golden, Mode mode)
+{
+    if(render.getNumChannels() != golden.getNumChannels() || render.getNumSamples() != golden.getNumSamples())
+        return -1.0;
+
+    const int numSamples = render.getNumSamples();
+
+    switch(mode){
+        case kExact: {
+            int numDifferent = 0;
+            for(int c=0; c<render.getNumChannels(); c++){
+                const float* a = render.getSampleData(c);
+                const float* b = golden.getSampleData(c);
+                if(memcmp(a, b, numSamples * sizeof(float)) != 0)
+                    for(int s=0; s<numSamples; s++)
+                        if(memcmp(a + s, b + s, sizeof(float)) != 0)
+                            numDifferent++;
+            }
+            return numDifferent;
+        }
+
+        case kMaxAbs: {
+            float maxError = 0.0f;
+            for(int c=0; c<render.getNumChannels(); c++){
+                const float* a = render.getSampleData(c);
+                const float* b = golden.getSampleData(c);
+                for(int s=0; s<numSamples; s++)
+                    maxError = jmax(maxError, std::abs(a[s] - b[s]));
+            }
+            return maxError;
+        }
+
+        case kSpectral:
+            return getSpectralDistance(render, golden);
+    }
+
+    return -1.0;
+}
+
+double Regression::getSpectralDistance(const AudioSampleBuffer& render, const AudioSampleBuffer& golden)
+{
+   #if JUCE_MAC || JUCE_IOS || DROWAUDIO_USE_FFTREAL
+    drow::FFTEngine fftRender (kFFTSizeLog2), fftGolden (kFFTSizeLog2);
+    fftRender.setWindowType(drow::Window::Hann);
+    fftGolden.setWindowType(drow::Window::Hann);
+
+    HeapBlock<float> frameRender (kFFTSize), frameGolden (kFFTSize);
+    const int numBins = kFFTSize / 2 + 1;
+    const int numSamples = render.getNumSamples();
+
+    double total = 0.0;
+    int numFrames = 0;
+
+    // frames overlap by half, and the last one is zero-padded
+    for(int c=0; c<render.getNumChannels(); c++){
+        for(int start = 0; start < numSamples; start += kFFTSize / 2){
+            const int size = jmin((int) kFFTSize, numSamples - start);
+            zeromem(frameRender, kFFTSize * sizeof(float));
+            zeromem(frameGolden, kFFTSize * sizeof(float));
+            FloatVectorOperations::copy(frameRender, render.getSampleData(c, start), size);
+            FloatVectorOperations::copy(frameGolden, golden.getSampleData(c, start), size);
+
+            fftRender.performFFT(frameRender);
+            fftRender.findMagnitudes();
+            fftGolden.performFFT(frameGolden);
+            fftGolden.findMagnitudes();
+
+            const float* a = fftRender.getMagnitudesBuffer().getData();
+            const float* b = fftGolden.getMagnitudesBuffer().getData();
+
+            // the RMS difference of the dB spectra
+            double sum = 0.0;
+            for(int bin=0; bin<numBins; bin++){
+                const double difference = 20.0 * std::log10(jmax(a[bin], kMagnitudeFloor) / jmax(b[bin], kMagnitudeFloor));
+                sum += difference * difference;
+            }
+
+            total += std::sqrt(sum / numBins);
+            numFrames++;
+        }
+    }
+
+    return numFrames ? total / numFrames : 0.0;
+   #else
+    // no FFTEngine on this platform - fall back to the max abs error
+    jassertfalse;
+    return compare(render, golden, kMaxAbs);
+   #endif
+}
+
+//==============================================================================
+bool Regression::saveGolden(const File& file, const AudioSampleBuffer& buffer)
+{
+    GoldenHeader header;
+    zerostruct(header);
+    memcpy(header.magic, "APDG", 4);
+    header.version = kGoldenVersion;
+    header.channels = buffer.getNumChannels();
+    header.samples = buffer.getNumSamples();
+    header.sampleRate = (float) kSampleRate;
+
+    // write to a temporary file first, so a failure never leaves a broken golden render
+    file.getParentDirectory().createDirectory();
+    TemporaryFile temp (file);
+    {
+        FileOutputStream out (temp.getFile());
+        if(!out.openedOk() || !out.write(&header, sizeof(header)))
+            return false;
+
+        for(int c=0; c<buffer.getNumChannels(); c++)
+            if(!out.write(buffer.getSampleData(c), buffer.getNumSamples() * sizeof(float)))
+                return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+bool Regression::loadGolden(const File& file, AudioSampleBuffer& buffer)
+{
+    FileInputStream in (file);
+    if(in.failedToOpen())
+        return false;
+
+    GoldenHeader header;
+    if(in.read(&header, sizeof(header)) != (int) sizeof(header)
+        || memcmp(header.magic, "APDG", 4) != 0 || header.version != kGoldenVersion
+        || header.sampleRate != (float) kSampleRate || header.channels <= 0 || header.samples < 0
+        || in.getTotalLength() != (int64) sizeof(header) + (int64) header.channels * header.samples * (int64) sizeof(float))
+        return false;
+
+    buffer.setSize(header.channels, header.samples);
+    for(int c=0; c<header.channels; c++)
+        if(in.read(buffer.getSampleData(c), header.samples * sizeof(float)) != (int) (header.samples * sizeof(float)))
+            return false;
+
+    return true;
+}
+
+//==============================================================================
+File Regression::getGoldenFolder()
+{
+    const String path (SystemStats::getEnvironmentVariable("APDI_GOLDEN_DIR", String::empty));
+    if(path.isNotEmpty())
+        return File::getCurrentWorkingDirectory().getChildFile(path);
+
+    return File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("APDI Golden Renders");
+}
+
+bool Regression::shouldUpdateGolden()
+{
+    return SystemStats::getEnvironmentVariable("APDI_UPDATE_GOLDEN", String::empty).isNotEmpty();
+}
+
+bool Regression::getModeOverride(Mode& mode)
+{
+    const String name (SystemStats::getEnvironmentVariable("APDI_REGRESSION_MODE", String::empty).trim());
+
+    for(int m=kExact; m<=kSpectral; m++){
+        if(name.equalsIgnoreCase(getModeName((Mode) m))){
+            mode = (Mode) m;
+            return true;
+        }
+    }
+    return false;
+}
+
+String Regression::getModeName(Mode mode)
+{
+    switch(mode){
+        case kExact:    return "exact";
+        case kMaxAbs:   return "maxabs";
+        case kSpectral: return "spectral";
+    }
+    return String::empty;
+}
+
+//==============================================================================
+#if APDI_REGRESSION_TESTS
+
+class RegressionTests : public UnitTest
+{
+public:
+    RegressionTests() : UnitTest("RegressionTests") {}
+
+    void runTest() {
+        const File folder (Regression::getGoldenFolder());
+        const bool bUpdate = Regression::shouldUpdateGolden();
+
+        OwnedArray<Regression::Scene> scenes;
+        Regression::addBuiltInScenes(scenes);
+        Regression::addScenesFromFolder(scenes, folder.getChildFile("Scenes"), Regression::kMaxAbs, 1.0e-6);
+
+        double totalCpuSeconds = 0.0;
+
+        for(int s=0; s<scenes.size(); s++){
+            beginTest(scenes[s]->name);
+
+            const Regression::Outcome outcome (Regression::run(*scenes[s], folder, bUpdate));
+            logMessage(scenes[s]->name + ": " + outcome.message);
+            expect(outcome.bPassed, outcome.message);
+
+            totalCpuSeconds += outcome.cpuSeconds;
+        }
+
+        logMessage("Total CPU time: " + String(totalCpuSeconds, 3) + "s (golden renders in " + folder.getFullPathName() + ")");
+    }
+};
+
+static RegressionTests regressionTests;
+
+#endif // APDI_REGRESSION_TESTS
+
+} // namespace APDI
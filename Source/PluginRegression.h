@@ -0,0 +1,107 @@
+//
+//  PluginRegression.h
+//  SynthPlugin
+//
+//  A regression harness for the synth's output, to check that optimisations of
+//  the voices, filters or FFT code haven't changed what it sounds like. A set of
+//  reference scenes (short MIDI sequences, each played with a program) is
+//  rendered offline and compared with golden renders stored on disk, and the
+//  CPU time taken by each scene is recorded, so a speedup can be judged on both
+//  its correctness and its measured gain.
+//
+//  Each scene is compared in one of three modes:
+//
+//      kExact      - every sample must be bit-for-bit identical
+//      kMaxAbs     - the largest absolute difference must be within the tolerance
+//      kSpectral   - the log-spectral distance (in dB, averaged over the frames
+//                    of a short-time FFT) must be within the tolerance
+//
+//  The golden renders are kept in the folder named by the environment variable
+//  APDI_GOLDEN_DIR (or "APDI Golden Renders" in the user's documents), with any
+//  extra scenes as MIDI files in its "Scenes" subfolder (played with program 0).
+//  A missing golden render is recorded rather than compared, as are all of them
+//  if APDI_UPDATE_GOLDEN is set. APDI_REGRESSION_MODE (exact, maxabs or spectral)
+//  overrides every scene's own mode. Timings are appended to timings.csv.
+//
+//  The UnitTest that runs all the scenes is built when APDI_REGRESSION_TESTS
+//  is set (off by default) - run it with a UnitTestRunner.
+//
+
+#ifndef _PluginRegression_h_
+#define _PluginRegression_h_
+
+#include "PluginProcessor.h"
+
+#ifndef APDI_REGRESSION_TESTS
+ #define APDI_REGRESSION_TESTS 0
+#endif
+
+namespace APDI
+{
+
+class Regression
+{
+public:
+    enum Mode
+    {
+        kExact = 0,
+        kMaxAbs,
+        kSpectral
+    };
+
+    struct Scene
+    {
+        String name;
+        MidiMessageSequence sequence;   // timestamped in seconds
+        int program;
+        double seconds;                 // length of the render (including any release tail)
+        Mode mode;
+        double tolerance;               // (unused in kExact mode)
+    };
+
+    struct Outcome
+    {
+        bool bPassed;
+        bool bRecorded;                 // no comparison was made - the render became the golden one
+        double error;                   // samples that differ, max abs error or distance in dB (by mode)
+        double cpuSeconds;              // CPU time taken to render the scene
+        double audioSeconds;
+        String message;                 // a description of the outcome
+    };
+
+    enum { kSampleRate = 44100, kBlockSize = 512, kNumberOfChannels = 2 };
+
+    // Adds the built-in reference scenes
+    static void addBuiltInScenes(OwnedArray<Scene>& scenes);
+
+    // Adds a scene for each MIDI file in a folder
+    static void addScenesFromFolder(OwnedArray<Scene>& scenes, const File& folder, Mode mode, double tolerance);
+
+    // Renders a scene with a new plugin instance (returns the CPU time taken, in seconds)
+    static double render(const Scene& scene, AudioSampleBuffer& output);
+
+    // Renders a scene, then compares it with (or records) its golden render in a folder
+    static Outcome run(const Scene& scene, const File& goldenFolder, bool updateGolden);
+
+    // Compares two renders (returns the error, as for Outcome::error, or a negative value
+    // if they don't have the same size)
+    static double compare(const AudioSampleBuffer& render, const AudioSampleBuffer& golden, Mode mode);
+
+    // Golden renders are stored as raw planar floats, after a small header
+    static bool saveGolden(const File& file, const AudioSampleBuffer& buffer);
+    static bool loadGolden(const File& file, AudioSampleBuffer& buffer);
+
+    // Settings from the environment (see above)
+    static File getGoldenFolder();
+    static bool shouldUpdateGolden();
+    static bool getModeOverride(Mode& mode);
+
+    static String getModeName(Mode mode);
+
+private:
+    static double getSpectralDistance(const AudioSampleBuffer& render, const AudioSampleBuffer& golden);
+};
+
+} // namespace APDI
+
+#endif
@@ -0,0 +1,256 @@
+//
+//  PluginResources.h
+//  SynthPlugin
+//
+//  A process-wide cache of decoded audio resources (e.g. the tables used by
+//  APDI::Wavetable), shared read-only between all voices and plugin instances.
+//
+//  Each resource is decoded once into a sidecar file of normalised floats in
+//  the temporary folder, which is then memory-mapped, so that the OS shares the
+//  same pages between every instance and later sessions skip decoding entirely.
+//
+
+#ifndef _PluginResources_h_
+#define _PluginResources_h_
+
+namespace APDI
+{
+
+// Returns the full path of a file in the plugin bundle's Resources folder
+static std::string getResourcePath(std::string filename){
+    CFBundleRef plugBundle = CFBundleGetBundleWithIdentifier(CFSTR("com.UWE.TestSynthAU"));
+    CFURLRef resourcesURL = CFBundleCopyResourcesDirectoryURL(plugBundle);
+    char path[PATH_MAX];
+    CFURLGetFileSystemRepresentation(resourcesURL, TRUE, (UInt8 *)path, PATH_MAX);
+    CFRelease(resourcesURL);
+
+    return std::string(path) + "/" + filename;
+}
+
+//==============================================================================
+/** Decoded, normalised and interleaved sample frames, as would be loaded into
+    the StkFrames of an stk::FileLoop (including the extra wrap-around frame). */
+class SharedTable : public ReferenceCountedObject
+{
+public:
+    typedef ReferenceCountedObjectPtr<SharedTable> Ptr;
+
+    const stk::StkFloat* getData() const { return pData; }
+    unsigned long getFrames() const { return frames; }          // including the wrap-around frame
+    unsigned long getFileSize() const { return frames - 1; }    // as stk::FileRead::fileSize()
+    unsigned int getChannels() const { return channels; }
+    stk::StkFloat getDataRate() const { return dataRate; }
+
+    const File& getSource() const { return source; }
+
+    // True if this was decoded from the given file as it is now (same path, size and modification time)
+    bool isFrom(const File& file) const {
+        return file == source && file.getSize() == sourceSize
+            && file.getLastModificationTime().toMilliseconds() == sourceTime;
+    }
+
+    // Opens a resource from its sidecar, (re)decoding the source file if needed
+    static SharedTable* open(const File& source) {
+        ScopedPointer<SharedTable> table (new SharedTable(source));
+
+        if(!table->map() && !(table->decode() && table->map()) && !table->load())
+            return NULL;
+
+        return table.release();
+    }
+
+private:
+    struct Header
+    {
+        char magic[4];
+        int32 version;
+        int64 sourceSize;
+        int64 sourceTime;
+        int32 channels;
+        int32 frames;
+        float dataRate;
+        int32 reserved;
+    };
+
+    enum { FORMAT_VERSION = 1 };
+
+    SharedTable(const File& source)
+    :   source(source), sourceSize(source.getSize()),
+        sourceTime(source.getLastModificationTime().toMilliseconds()),
+        pData(NULL), frames(0), channels(0), dataRate(0)
+    {
+        sidecar = File::getSpecialLocation(File::tempDirectory)
+                    .getChildFile("APDI Resource Cache")
+                    .getChildFile(String::toHexString(source.getFullPathName().hashCode64()) + ".f32");
+    }
+
+    void fillHeader(Header& header) const {
+        zerostruct(header);
+        memcpy(header.magic, "APDI", 4);
+        header.version = FORMAT_VERSION;
+        header.sourceSize = sourceSize;
+        header.sourceTime = sourceTime;
+    }
+
+    // Maps an up-to-date sidecar file, if there is one
+    bool map() {
+        mapping = new MemoryMappedFile(sidecar, MemoryMappedFile::readOnly);
+        if(mapping->getData() == nullptr || mapping->getSize() < sizeof(Header)){
+            mapping = nullptr;
+            return false;
+        }
+
+        Header expected, header;
+        fillHeader(expected);
+        memcpy(&header, mapping->getData(), sizeof(Header));
+
+        if(memcmp(header.magic, expected.magic, 4) != 0 || header.version != expected.version
+           || header.sourceSize != expected.sourceSize || header.sourceTime != expected.sourceTime
+           || mapping->getSize() < sizeof(Header) + sizeof(stk::StkFloat) * header.frames * header.channels){
+            mapping = nullptr;
+            return false;
+        }
+
+        pData = (const stk::StkFloat*) addBytesToPointer(mapping->getData(), (int) sizeof(Header));
+        frames = header.frames;
+        channels = header.channels;
+        dataRate = header.dataRate;
+        return true;
+    }
+
+    // Decodes the source into memory (as FileLoop::openFile() followed by normalize())
+    bool read(stk::StkFrames& data) {
+        try {
+            stk::FileRead file(source.getFullPathName().toStdString());
+            data.resize(file.fileSize() + 1, file.channels());
+            data.setDataRate(file.fileRate());
+
+            stk::StkFrames samples(file.fileSize(), file.channels());
+            file.read(samples);
+
+            stk::StkFloat peak = 0.0;
+            for(unsigned long i=0; i<samples.size(); i++)
+                peak = jmax(peak, (stk::StkFloat) fabs(samples[i]));
+            const stk::StkFloat gain = peak > 0.0 ? 1.0 / peak : 1.0;
+
+            for(unsigned long i=0; i<samples.size(); i++)
+                data[i] = samples[i] * gain;
+            for(unsigned int c=0; c<data.channels(); c++)
+                data(data.frames() - 1, c) = data[c];
+
+            return true;
+        }
+        catch(stk::StkError&) {
+            return false;
+        }
+    }
+
+    // Decodes the source and writes the sidecar file
+    bool decode() {
+        stk::StkFrames data;
+        if(!read(data))
+            return false;
+
+        Header header;
+        fillHeader(header);
+        header.channels = data.channels();
+        header.frames = (int32) data.frames();
+        header.dataRate = data.dataRate();
+
+        // write to a temporary file first, so other instances never map a partial table
+        TemporaryFile temp(sidecar);
+        {
+            sidecar.getParentDirectory().createDirectory();
+            ScopedPointer<FileOutputStream> out (temp.getFile().createOutputStream());
+            if(out == nullptr
+               || !out->write(&header, sizeof(Header))
+               || !out->write(&data[0], sizeof(stk::StkFloat) * data.size()))
+                return false;
+        }
+        return temp.overwriteTargetFileWithTemporary();
+    }
+
+    // Keeps a private copy, if the cache folder is unusable
+    bool load() {
+        stk::StkFrames data;
+        if(!read(data))
+            return false;
+
+        memory.malloc(data.size());
+        memcpy(memory, &data[0], sizeof(stk::StkFloat) * data.size());
+
+        pData = memory;
+        frames = data.frames();
+        channels = data.channels();
+        dataRate = data.dataRate();
+        return true;
+    }
+
+    File source, sidecar;
+    int64 sourceSize, sourceTime;
+    ScopedPointer<MemoryMappedFile> mapping;
+    HeapBlock<stk::StkFloat> memory;
+
+    const stk::StkFloat* pData;
+    unsigned long frames;
+    unsigned int channels;
+    stk::StkFloat dataRate;
+
+    JUCE_DECLARE_NON_COPYABLE (SharedTable)
+};
+
+//==============================================================================
+/** The process-wide set of open SharedTables, keyed by source file, size and modification time. */
+class ResourceCache : public DeletedAtShutdown
+{
+public:
+    static ResourceCache* getInstance() {
+        const SpinLock::ScopedLockType lock(getLock());
+        if(getPointer() == NULL)
+            getPointer() = new ResourceCache();
+        return getPointer();
+    }
+
+    ~ResourceCache() {
+        const SpinLock::ScopedLockType lock(getLock());
+        getPointer() = NULL;
+    }
+
+    // Returns the shared table for a file (not for use on the audio thread)
+    SharedTable::Ptr open(const File& file) {
+        const ScopedLock lock(tablesLock);
+
+        // drop tables that nothing else is using any more
+        for(int t=tables.size(); --t >= 0;)
+            if(tables.getUnchecked(t)->getReferenceCount() == 1)
+                tables.remove(t);
+
+        for(int t=0; t<tables.size(); t++)
+            if(tables.getUnchecked(t)->isFrom(file))
+                return tables.getUnchecked(t);
+
+        SharedTable* table = SharedTable::open(file);
+        if(table)
+            tables.add(table);
+        return table;
+    }
+
+    SharedTable::Ptr openResource(std::string filename) {
+        return open(File(getResourcePath(filename)));
+    }
+
+private:
+    ResourceCache() {}
+
+    static SpinLock& getLock() { static SpinLock lock; return lock; }
+    static ResourceCache*& getPointer() { static ResourceCache* cache = NULL; return cache; }
+
+    ReferenceCountedArray<SharedTable> tables;
+    CriticalSection tablesLock;
+
+    JUCE_DECLARE_NON_COPYABLE (ResourceCache)
+};
+
+} // namespace APDI
+
+#endif
@@ -0,0 +1,352 @@
+//
+//  PluginSanitizer.cpp
+//  SynthPlugin
+//
+//  The hooks for APDI::RealtimeSanitizer (see PluginSanitizer.h).
+//
+//  Everything here may be called from inside malloc or a mutex lock, so it must
+//  not allocate or lock itself: the per-thread state is kept in pthread keys
+//  (which never allocate, unlike __thread on the Mac), the violations are kept
+//  in fixed-size static tables, and stack traces are only symbolised in getReport().
+//
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "PluginSanitizer.h"
+
+#if APDI_REALTIME_SANITIZER
+
+#include <pthread.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <new>
+
+namespace APDI
+{
+
+namespace
+{
+    enum { kMaxRecords = 64, kMaxFrames = 32, kFramesToSkip = 3 };
+
+    struct Record
+    {
+        int type;
+        int numFrames;
+        void* frames[kMaxFrames];
+        Atomic<int> complete;
+    };
+
+    const char* const VIOLATION_NAMES[RealtimeSanitizer::kNumberOfViolations] = {
+        "memory allocation", "memory deallocation", "mutex lock", "file access"
+    };
+
+    Record records[kMaxRecords];
+    Atomic<int> numRecords;
+    Atomic<int> counts[RealtimeSanitizer::kNumberOfViolations];
+
+    // per-thread depth of ScopedRealtime and ScopedNonRealtime objects
+    pthread_key_t realtimeKey, nonRealtimeKey;
+    volatile bool bInstalled = false;
+
+    intptr_t getDepth(pthread_key_t key) { return (intptr_t) pthread_getspecific(key); }
+    void addDepth(pthread_key_t key, intptr_t delta) { pthread_setspecific(key, (void*) (getDepth(key) + delta)); }
+
+    // called by each hook
+    void check(RealtimeSanitizer::Violation type) {
+        if(bInstalled && RealtimeSanitizer::isRealtimeThread()){
+            const RealtimeSanitizer::ScopedNonRealtime guard; // anything we do here is not a violation
+            RealtimeSanitizer::violation(type);
+        }
+    }
+}
+
+//==============================================================================
+void RealtimeSanitizer::install()
+{
+    static SpinLock lock;
+    const SpinLock::ScopedLockType sl(lock);
+
+    if(bInstalled)
+        return;
+
+    pthread_key_create(&realtimeKey, NULL);
+    pthread_key_create(&nonRealtimeKey, NULL);
+
+    // the first stack trace may load libraries (and allocate), so get it out of the way now
+    void* frames[kMaxFrames];
+    backtrace(frames, kMaxFrames);
+
+    installHooks();
+    bInstalled = true;
+}
+
+int RealtimeSanitizer::getCount(Violation type)
+{
+    return isPositiveAndBelow((int) type, (int) kNumberOfViolations) ? counts[type].get() : 0;
+}
+
+int RealtimeSanitizer::getTotalCount()
+{
+    int total = 0;
+    for(int t=0; t<kNumberOfViolations; t++)
+        total += counts[t].get();
+    return total;
+}
+
+void RealtimeSanitizer::reset()
+{
+    for(int t=0; t<kNumberOfViolations; t++)
+        counts[t].set(0);
+
+    for(int r=0; r<kMaxRecords; r++)
+        records[r].complete.set(0);
+
+    numRecords.set(0);
+}
+
+bool RealtimeSanitizer::isRealtimeThread()
+{
+    return getDepth(realtimeKey) > 0 && getDepth(nonRealtimeKey) == 0;
+}
+
+void RealtimeSanitizer::violation(Violation type)
+{
+    ++counts[type];
+
+    const int index = (numRecords += 1) - 1;
+    if(index < kMaxRecords){
+        Record& record = records[index];
+        record.type = type;
+        record.numFrames = backtrace(record.frames, kMaxFrames);
+        record.complete.set(1);
+    }
+}
+
+String RealtimeSanitizer::getReport()
+{
+    const ScopedNonRealtime guard;
+    String report;
+
+    report << "Real-time safety violations: " << getTotalCount() << newLine;
+    for(int t=0; t<kNumberOfViolations; t++)
+        report << "    " << VIOLATION_NAMES[t] << ": " << counts[t].get() << newLine;
+
+    const int numToReport = jmin(numRecords.get(), (int) kMaxRecords);
+    for(int r=0; r<numToReport; r++){
+        const Record& record = records[r];
+        if(record.complete.get() == 0)
+            continue;
+
+        report << newLine << "#" << (r + 1) << " " << VIOLATION_NAMES[record.type] << " at:" << newLine;
+
+        if(char** symbols = backtrace_symbols(record.frames, record.numFrames)){
+            for(int f=kFramesToSkip; f<record.numFrames; f++)
+                report << "    " << symbols[f] << newLine;
+            ::free(symbols);
+        }
+    }
+
+    if(numRecords.get() > kMaxRecords)
+        report << newLine << "(only the first " << (int) kMaxRecords << " stack traces were kept)" << newLine;
+
+    return report;
+}
+
+void RealtimeSanitizer::checkForViolations()
+{
+    if(getTotalCount() == 0)
+        return;
+
+    Logger::writeToLog(getReport());
+
+    if(SystemStats::getEnvironmentVariable("APDI_REALTIME_SANITIZER_FATAL", String::empty).isNotEmpty())
+        std::abort();
+}
+
+//==============================================================================
+RealtimeSanitizer::ScopedRealtime::ScopedRealtime()         { if(bInstalled) addDepth(realtimeKey, 1); }
+RealtimeSanitizer::ScopedRealtime::~ScopedRealtime()        { if(bInstalled) addDepth(realtimeKey, -1); }
+
+RealtimeSanitizer::ScopedNonRealtime::ScopedNonRealtime()   { if(bInstalled) addDepth(nonRealtimeKey, 1); }
+RealtimeSanitizer::ScopedNonRealtime::~ScopedNonRealtime()  { if(bInstalled) addDepth(nonRealtimeKey, -1); }
+
+} // namespace APDI
+
+using APDI::RealtimeSanitizer;
+
+//==============================================================================
+#if JUCE_MAC
+
+// libmalloc calls this (if set) after every allocation and deallocation in the process
+typedef void (MallocLogger)(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3,
+                            uintptr_t result, uint32_t numFramesToSkip);
+extern "C" MallocLogger* malloc_logger;
+
+static MallocLogger* previousMallocLogger = NULL;
+
+enum { MALLOC_LOG_TYPE_ALLOCATE = 2, MALLOC_LOG_TYPE_DEALLOCATE = 4 };
+
+static void sanitizerMallocLogger(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3,
+                                  uintptr_t result, uint32_t numFramesToSkip)
+{
+    if(previousMallocLogger)
+        previousMallocLogger(type, arg1, arg2, arg3, result, numFramesToSkip + 1);
+
+    if(type & MALLOC_LOG_TYPE_ALLOCATE)
+        APDI::check(RealtimeSanitizer::kAllocation);
+    else if(type & MALLOC_LOG_TYPE_DEALLOCATE)
+        APDI::check(RealtimeSanitizer::kDeallocation);
+}
+
+// Calls from the plugin's own code (including JUCE and STK) bind to these, rather than to
+// libSystem, which they forward to. They are looked up without function-local statics,
+// as the static initialisation guard itself takes a lock.
+static int (*realMutexLock)(pthread_mutex_t*) = NULL;
+static int (*realOpen)(const char*, int, ...) = NULL;
+static FILE* (*realFopen)(const char*, const char*) = NULL;
+static ssize_t (*realRead)(int, void*, size_t) = NULL;
+static ssize_t (*realWrite)(int, const void*, size_t) = NULL;
+
+template <typename FunctionType>
+static inline FunctionType lookUp(FunctionType& function, const char* name)
+{
+    if(function == NULL)
+        function = (FunctionType) dlsym(RTLD_NEXT, name);
+    return function;
+}
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    APDI::check(RealtimeSanitizer::kLock);
+    return lookUp(realMutexLock, "pthread_mutex_lock")(mutex);
+}
+
+extern "C" int open(const char* path, int flags, ...)
+{
+    int mode = 0;
+    if(flags & O_CREAT){
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, int);
+        va_end(args);
+    }
+
+    APDI::check(RealtimeSanitizer::kFileAccess);
+    return lookUp(realOpen, "open")(path, flags, mode);
+}
+
+extern "C" FILE* fopen(const char* path, const char* mode)
+{
+    APDI::check(RealtimeSanitizer::kFileAccess);
+    return lookUp(realFopen, "fopen")(path, mode);
+}
+
+extern "C" ssize_t read(int file, void* buffer, size_t size)
+{
+    APDI::check(RealtimeSanitizer::kFileAccess);
+    return lookUp(realRead, "read")(file, buffer, size);
+}
+
+extern "C" ssize_t write(int file, const void* buffer, size_t size)
+{
+    APDI::check(RealtimeSanitizer::kFileAccess);
+    return lookUp(realWrite, "write")(file, buffer, size);
+}
+
+void RealtimeSanitizer::installHooks()
+{
+    lookUp(realMutexLock, "pthread_mutex_lock");
+    lookUp(realOpen, "open");
+    lookUp(realFopen, "fopen");
+    lookUp(realRead, "read");
+    lookUp(realWrite, "write");
+
+    previousMallocLogger = malloc_logger;
+    malloc_logger = sanitizerMallocLogger;
+}
+
+//==============================================================================
+#else
+
+// Elsewhere, only the allocations made with new and delete can be caught (not malloc, locks
+// or file access), so every form of them is replaced: plain, array and nothrow, and the
+// sized and aligned forms where the compiler has them.
+static void* allocate(size_t size)
+{
+    APDI::check(RealtimeSanitizer::kAllocation);
+    return ::malloc(size ? size : 1);
+}
+
+static void deallocate(void* p)
+{
+    if(p) APDI::check(RealtimeSanitizer::kDeallocation);
+    ::free(p);
+}
+
+void* operator new (size_t size)
+{
+    if(void* p = allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size)
+{
+    if(void* p = allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new (size_t size, const std::nothrow_t&) throw()     { return allocate(size); }
+void* operator new[] (size_t size, const std::nothrow_t&) throw()   { return allocate(size); }
+
+void operator delete (void* p) throw()                              { deallocate(p); }
+void operator delete[] (void* p) throw()                            { deallocate(p); }
+void operator delete (void* p, const std::nothrow_t&) throw()       { deallocate(p); }
+void operator delete[] (void* p, const std::nothrow_t&) throw()     { deallocate(p); }
+
+#if defined (__cpp_sized_deallocation)
+void operator delete (void* p, size_t) throw()                      { deallocate(p); }
+void operator delete[] (void* p, size_t) throw()                    { deallocate(p); }
+#endif
+
+#if defined (__cpp_aligned_new)
+static void* allocateAligned(size_t size, std::align_val_t alignment)
+{
+    APDI::check(RealtimeSanitizer::kAllocation);
+    void* p = NULL;
+    const size_t align = jmax((size_t) alignment, sizeof(void*));
+    return posix_memalign(&p, align, size ? size : 1) == 0 ? p : NULL;
+}
+
+void* operator new (size_t size, std::align_val_t alignment)
+{
+    if(void* p = allocateAligned(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size, std::align_val_t alignment)
+{
+    if(void* p = allocateAligned(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new (size_t size, std::align_val_t alignment, const std::nothrow_t&) throw()      { return allocateAligned(size, alignment); }
+void* operator new[] (size_t size, std::align_val_t alignment, const std::nothrow_t&) throw()    { return allocateAligned(size, alignment); }
+
+void operator delete (void* p, std::align_val_t) throw()                                { deallocate(p); }
+void operator delete[] (void* p, std::align_val_t) throw()                              { deallocate(p); }
+void operator delete (void* p, size_t, std::align_val_t) throw()                        { deallocate(p); }
+void operator delete[] (void* p, size_t, std::align_val_t) throw()                      { deallocate(p); }
+void operator delete (void* p, std::align_val_t, const std::nothrow_t&) throw()         { deallocate(p); }
+void operator delete[] (void* p, std::align_val_t, const std::nothrow_t&) throw()       { deallocate(p); }
+#endif
+
+void RealtimeSanitizer::installHooks() {}
+
+#endif
+
+#endif // APDI_REALTIME_SANITIZER
@@ -0,0 +1,103 @@
+//
+//  PluginSanitizer.h
+//  SynthPlugin
+//
+//  A debug-build check for real-time safety. Code that runs on the audio thread
+//  is marked with a ScopedRealtime object (see PluginAudioProcessor::processBlock),
+//  and any memory allocation, mutex lock or file access made inside that scope
+//  is counted as a violation, along with the stack trace where it happened.
+//
+//  Enabled by APDI_REALTIME_SANITIZER (on by default in debug builds). On the
+//  Mac, malloc/free are watched for every library in the process, and locks
+//  (pthread_mutex_lock) and file access (open, fopen, read and write) for all the
+//  code built into the plugin (including JUCE and STK). Elsewhere, the checks are
+//  for allocation only: every form of operator new/delete is watched, but not
+//  malloc/free, locks or file access.
+//
+//  Violations are only counted and logged - they never stop the audio thread. The
+//  one way they fail a run is when the processor is deleted: its destructor calls
+//  checkForViolations(), which logs a report and, if the environment variable
+//  APDI_REALTIME_SANITIZER_FATAL is set, aborts (e.g. to fail a test run).
+//
+
+#ifndef _PluginSanitizer_h_
+#define _PluginSanitizer_h_
+
+#ifndef APDI_REALTIME_SANITIZER
+ #define APDI_REALTIME_SANITIZER JUCE_DEBUG
+#endif
+
+namespace APDI
+{
+
+class RealtimeSanitizer
+{
+public:
+    enum Violation
+    {
+        kAllocation = 0,
+        kDeallocation,
+        kLock,
+        kFileAccess,
+        kNumberOfViolations
+    };
+
+   #if APDI_REALTIME_SANITIZER
+    // Installs the hooks (safe to call more than once)
+    static void install();
+
+    static int getCount(Violation type);
+    static int getTotalCount();
+    static void reset();
+
+    // A description of the violations, with the first few stack traces (not for the audio thread)
+    static String getReport();
+
+    // Logs any violations so far (and stops, if APDI_REALTIME_SANITIZER_FATAL is set)
+    static void checkForViolations();
+
+    static bool isRealtimeThread();
+
+    // called by the hooks
+    static void violation(Violation type);
+
+    /** Marks the current thread as real-time for the lifetime of this object. */
+    class ScopedRealtime
+    {
+    public:
+        ScopedRealtime();
+        ~ScopedRealtime();
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtime)
+    };
+
+    /** Allows an intentional violation inside a real-time scope (use sparingly!) */
+    class ScopedNonRealtime
+    {
+    public:
+        ScopedNonRealtime();
+        ~ScopedNonRealtime();
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedNonRealtime)
+    };
+
+private:
+    static void installHooks();
+   #else
+    static void install() {}
+
+    static int getCount(Violation) { return 0; }
+    static int getTotalCount() { return 0; }
+    static void reset() {}
+    static String getReport() { return String::empty; }
+    static void checkForViolations() {}
+    static bool isRealtimeThread() { return false; }
+
+    struct ScopedRealtime { ScopedRealtime() {} };
+    struct ScopedNonRealtime { ScopedNonRealtime() {} };
+   #endif
+};
+
+} // namespace APDI
+
+#endif
@@ -0,0 +1,316 @@
+//
+//  PluginStreaming.h
+//  SynthPlugin
+//
+//  Disk-streaming sample playback, for multisampled instruments that are too
+//  large to hold in memory (see APDI::Buffer for small, fully-loaded samples).
+//
+//  Each StreamingFile keeps the head of its audio file in memory, so that a
+//  note can start immediately. The rest of the file is read by a shared pool
+//  of background threads into a lock-free ring buffer owned by each playing
+//  StreamingBuffer, so the audio thread never touches the disk.
+//
+
+#ifndef _PluginStreaming_h_
+#define _PluginStreaming_h_
+
+namespace APDI
+{
+
+//==============================================================================
+/** The background threads that prefetch audio for all StreamingBuffers in the process. */
+class StreamingThreadPool : public DeletedAtShutdown
+{
+public:
+    static StreamingThreadPool* getInstance() {
+        const SpinLock::ScopedLockType lock(getLock());
+        if(getPointer() == NULL)
+            getPointer() = new StreamingThreadPool();
+        return getPointer();
+    }
+
+    ~StreamingThreadPool() {
+        for(int t=0; t<threads.size(); t++)
+            threads[t]->stopThread(1000);
+
+        const SpinLock::ScopedLockType lock(getLock());
+        getPointer() = NULL;
+    }
+
+    // clients are spread across the threads, so that a slow disk read only stalls some voices
+    void addClient(TimeSliceClient* client) {
+        const int thread = (nextThread += 1) % threads.size();
+        threads[thread]->addTimeSliceClient(client);
+    }
+
+    void removeClient(TimeSliceClient* client) {
+        for(int t=0; t<threads.size(); t++)
+            threads[t]->removeTimeSliceClient(client);
+    }
+
+private:
+    StreamingThreadPool() {
+        const int numThreads = jlimit(1, 4, SystemStats::getNumCpus() / 2);
+
+        for(int t=0; t<numThreads; t++){
+            TimeSliceThread* thread = threads.add(new TimeSliceThread("Sample Streaming Thread " + String(t + 1)));
+            thread->startThread(8); // above normal, so that prefetching keeps ahead of playback
+        }
+    }
+
+    static SpinLock& getLock() { static SpinLock lock; return lock; }
+    static StreamingThreadPool*& getPointer() { static StreamingThreadPool* pool = NULL; return pool; }
+
+    OwnedArray<TimeSliceThread> threads;
+    Atomic<int> nextThread;
+
+    JUCE_DECLARE_NON_COPYABLE (StreamingThreadPool)
+};
+
+//==============================================================================
+/** An audio file opened for streaming - shared between all the voices that play it. */
+class StreamingFile : public ReferenceCountedObject
+{
+public:
+    typedef ReferenceCountedObjectPtr<StreamingFile> Ptr;
+
+    enum { DEFAULT_HEAD_SIZE = 65536 }; // frames held in memory (~1.5s at 44.1kHz)
+
+    StreamingFile(const File& file, int headSize = DEFAULT_HEAD_SIZE)
+    :   head(2, 1), length(0), sampleRate(44100.0), bMapped(false)
+    {
+        AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        // WAV and AIFF can be memory-mapped, so prefetching is just a page-in of the file
+        if(AudioFormat* format = formats.findFormatForFileExtension(file.getFileExtension())){
+            ScopedPointer<MemoryMappedAudioFormatReader> mapped (format->createMemoryMappedReader(file));
+            if(mapped != nullptr && mapped->mapEntireFile()){
+                reader = mapped.release();
+                bMapped = true;
+            }
+        }
+
+        if(reader == nullptr)
+            reader = formats.createReaderFor(file);
+
+        if(reader != nullptr){
+            length = reader->lengthInSamples;
+            sampleRate = reader->sampleRate;
+
+            head.setSize(2, (int) jmin((int64) headSize, length) + 1);
+            head.clear();
+            reader->read(&head, 0, head.getNumSamples() - 1, 0, true, true);
+        }
+    }
+
+    static Ptr openResource(std::string filename, int headSize = DEFAULT_HEAD_SIZE) {
+        return new StreamingFile(File(getResourcePath(filename)), headSize);
+    }
+
+    bool isValid() const { return reader != nullptr; }
+    bool isMemoryMapped() const { return bMapped; }
+
+    int64 getSize() const { return length; }
+    int getHeadSize() const { return head.getNumSamples() - 1; }
+    double getFileRate() const { return sampleRate; }
+
+    const AudioSampleBuffer& getHead() const { return head; }
+
+    // called from the streaming threads only (never the audio thread)
+    void read(AudioSampleBuffer& destination, int startSample, int64 position, int numSamples) {
+        if(bMapped){
+            // mapped readers hold no stream state, so can be shared between threads without locking
+            reader->read(&destination, startSample, numSamples, position, true, true);
+        }else{
+            const ScopedLock lock(readLock);
+            reader->read(&destination, startSample, numSamples, position, true, true);
+        }
+    }
+
+private:
+    ScopedPointer<AudioFormatReader> reader;
+    AudioSampleBuffer head;
+    CriticalSection readLock;
+
+    int64 length;
+    double sampleRate;
+    bool bMapped;
+
+    JUCE_DECLARE_NON_COPYABLE (StreamingFile)
+};
+
+//==============================================================================
+/** A per-voice player for StreamingFiles (the streaming equivalent of Buffer). */
+class StreamingBuffer : public TimeSliceClient
+{
+public:
+    enum { DEFAULT_RING_SIZE = 32768 }; // frames prefetched ahead of the play position
+
+    StreamingBuffer(int ringSize = DEFAULT_RING_SIZE)
+    :   fifo(ringSize), ring(2, ringSize), pFile(NULL), position(0), skip(0), time(0.0), rate(1.0),
+        fBaseFrequency(261.626), pStreamFile(NULL), streamPosition(0), servedGeneration(0), underruns(0)
+    {
+        ring.clear();
+        for(int c=0; c<2; c++)
+            frame[0][c] = frame[1][c] = last[c] = 0.0f;
+
+        StreamingThreadPool::getInstance()->addClient(this);
+    }
+
+    ~StreamingBuffer() {
+        StreamingThreadPool::getInstance()->removeClient(this);
+    }
+
+    // Starts playing a file from the beginning (safe to call on the audio thread).
+    // The StreamingFile must be kept alive elsewhere (e.g. by the synth) while it is playing.
+    void play(StreamingFile* file) {
+        pFile = file != nullptr && file->isValid() ? file : NULL;
+        position = 0;
+        skip = 0;
+        time = 0.0;
+        for(int c=0; c<2; c++)
+            frame[0][c] = frame[1][c] = last[c] = 0.0f;
+
+        if(pFile)
+            rate = pFile->getFileRate() / stk::Stk::sampleRate();
+
+        requestedFile.set(pFile);
+        requestedGeneration += 1;
+    }
+
+    void stop() { play(NULL); }
+
+    bool isPlaying() const { return pFile != NULL && time < pFile->getSize(); }
+
+    void setRate(double rate) { this->rate = rate; }
+
+    void setFrequency(float frequency) {
+        if(pFile)
+            setRate((frequency / fBaseFrequency) * pFile->getFileRate() / stk::Stk::sampleRate());
+    }
+
+    void setBaseFrequency(float frequency) { fBaseFrequency = frequency; }
+
+    float tick() {
+        if(!isPlaying())
+            return last[0] = last[1] = 0.0f;
+
+        const int64 index = (int64) time;
+        while(position <= index + 1){
+            frame[0][0] = frame[1][0];
+            frame[0][1] = frame[1][1];
+            nextFrame(frame[1]);
+        }
+
+        const float alpha = (float)(time - index);
+        for(int c=0; c<2; c++)
+            last[c] = frame[0][c] + alpha * (frame[1][c] - frame[0][c]);
+
+        time += rate;
+        return last[0];
+    }
+
+    float lastOut(int channel = 0) const { return last[channel]; }
+
+    // the number of frames that were not ready in time (played as silence)
+    int getUnderruns() const { return underruns.get(); }
+
+    //==========================================================================
+    int useTimeSlice() {
+        const int generation = requestedGeneration.get();
+        if(generation != servedGeneration){
+            // new note - discard the old stream and continue from the end of the new file's head
+            pStreamFile = requestedFile.get();
+            fifo.reset();
+            streamPosition = pStreamFile ? pStreamFile->getHeadSize() : 0;
+            servedGeneration = generation;
+            readyGeneration.set(generation);
+        }
+
+        if(pStreamFile == NULL || streamPosition >= pStreamFile->getSize())
+            return 20;
+
+        int start1, size1, start2, size2;
+        const int numToRead = (int) jmin((int64) fifo.getFreeSpace(), pStreamFile->getSize() - streamPosition, (int64) 4096);
+        if(numToRead <= 0)
+            return 5;
+
+        fifo.prepareToWrite(numToRead, start1, size1, start2, size2);
+        if(size1 > 0)
+            pStreamFile->read(ring, start1, streamPosition, size1);
+        if(size2 > 0)
+            pStreamFile->read(ring, start2, streamPosition + size1, size2);
+        fifo.finishedWrite(size1 + size2);
+
+        streamPosition += size1 + size2;
+        return 0;
+    }
+
+private:
+    void nextFrame(float* out) {
+        const int64 index = position++;
+
+        if(index >= pFile->getSize()){
+            out[0] = out[1] = 0.0f;
+        }else if(index < pFile->getHeadSize()){
+            out[0] = *pFile->getHead().getSampleData(0, (int) index);
+            out[1] = *pFile->getHead().getSampleData(1, (int) index);
+        }else if(readyGeneration.get() == requestedGeneration.get() && readFrame(out)){
+            // read from the prefetched stream
+        }else{
+            out[0] = out[1] = 0.0f;
+            ++underruns;
+            ++skip; // stay in step with the stream once it catches up
+        }
+    }
+
+    bool readFrame(float* out) {
+        int start1, size1, start2, size2;
+
+        if(skip){
+            fifo.prepareToRead(skip, start1, size1, start2, size2);
+            fifo.finishedRead(size1 + size2);
+            skip -= size1 + size2;
+            if(skip)
+                return false;
+        }
+
+        fifo.prepareToRead(1, start1, size1, start2, size2);
+        if(size1 == 0)
+            return false;
+
+        out[0] = *ring.getSampleData(0, start1);
+        out[1] = *ring.getSampleData(1, start1);
+        fifo.finishedRead(1);
+        return true;
+    }
+
+    AbstractFifo fifo;
+    AudioSampleBuffer ring;
+
+    // audio thread state
+    StreamingFile* pFile;
+    int64 position;
+    int skip;
+    double time, rate;
+    float fBaseFrequency;
+    float frame[2][2];
+    float last[2];
+
+    // streaming thread state
+    StreamingFile* pStreamFile;
+    int64 streamPosition;
+    int servedGeneration;
+
+    // shared state
+    Atomic<StreamingFile*> requestedFile;
+    Atomic<int> requestedGeneration, readyGeneration;
+    Atomic<int> underruns;
+
+    JUCE_DECLARE_NON_COPYABLE (StreamingBuffer)
+};
+
+} // namespace APDI
+
+#endif
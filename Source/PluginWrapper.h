@@ -12,6 +12,9 @@
 #define _PluginWrapper_h_
 
 #include "PluginProcessor.h"
+#include "PluginResources.h"
+#include "PluginContext.h"
+#include "PluginDenormals.h"
 
 //==============================================================================
 // DSP OBJECTS - These STK objects have been adapted to support UWE development.
@@ -26,8 +29,8 @@ namespace APDI
 
 typedef stk::Generator Oscillator;
 
-static float SAMPLE_RATE = 0.0f;
-static float getSampleRate() { return SAMPLE_RATE; }
+// The sample rate of the plugin instance being processed (see Context)
+static float getSampleRate() { return stk::Stk::sampleRate(); }
 
 class Sine : public stk::SineWave
 {
@@ -49,9 +52,62 @@ class Square : public stk::BlitSquare {};
 class Saw : public stk::BlitSaw {};
 class Noise : public stk::Noise {};
 
-class Delay : public stk::DelayL {};
+class Delay : public stk::FastTapDelay {   // (interpolating, as stk::DelayL)
+public:
+    // zeroes any of the delay line's contents that have decayed below the threshold
+    void flush(float threshold = kDenormalThreshold) {
+        flushDenormals(&ring_[0], (int)ring_.size(), threshold);
+    }
+};
+
+class FIR : public stk::FastFir {
+public:
+    // zeroes any of the filter's past inputs that have decayed below the threshold
+    void flush(float threshold = kDenormalThreshold) {
+        flushDenormals(&history_[0], (int)history_.size(), threshold);
+    }
+};
+
+// A 2-D waveguide mesh (of up to 64 x 64 junctions), struck with noteOn()
+class Mesh : public stk::FastMesh2D {
+public:
+    Mesh(int sizeX = 16, int sizeY = 16) : stk::FastMesh2D(sizeX, sizeY) {}
+};
+
+// Detects when a signal has fallen silent (stayed below a threshold for a hold time)
+class SilenceDetector {
+public:
+    SilenceDetector(float thresholdDecibels = -80.0f, float holdSeconds = 0.1f)
+    :   fThreshold(Decibels::decibelsToGain(thresholdDecibels)), fHoldSeconds(holdSeconds), iSilentSamples(0) {}
+    
+    void reset() { iSilentSamples = 0; }
+    
+    // returns true once the signal has been silent for the hold time
+    bool process(const float* samples, int numSamples) {
+        float fMin, fMax;
+        FloatVectorOperations::findMinAndMax(samples, numSamples, fMin, fMax);
+        
+        if(fMax > fThreshold || -fMin > fThreshold)
+            iSilentSamples = 0;
+        else
+            iSilentSamples += numSamples;
+        
+        return iSilentSamples >= fHoldSeconds * getSampleRate();
+    }
+    
+private:
+    float fThreshold, fHoldSeconds;
+    int iSilentSamples;
+};
 
-class Filter : public stk::BiQuad {};
+class Filter : public stk::BiQuad {
+public:
+    // zeroes any of the filter's state that has decayed below the threshold
+    void flush(float threshold = kDenormalThreshold) {
+        flushDenormals(&inputs_[0], (int)inputs_.size(), threshold);
+        flushDenormals(&outputs_[0], (int)outputs_.size(), threshold);
+    }
+};
 class LPF : public Filter {
 public:
     LPF() : Filter() {
@@ -60,7 +116,7 @@ public:
     
     void setCutoff(float frequency){
         Float32 fOmega = M_PI * (frequency/sampleRate());
-		Float32 fKval = tan(fOmega);
+		Float32 fKval = drow::FastMath::tan(fOmega);
 		Float32 fKvalsq = fKval * fKval;
 		Float32 fRootTwo = sqrt(2.0);
 		Float32 ffrac = 1.0 / (1.0 + fRootTwo * fKval + fKvalsq);
@@ -82,7 +138,7 @@ public:
     
     void setCutoff(float frequency){
         Float32 fOmega = M_PI * (frequency/sampleRate());
-		Float32 fKval = tan(fOmega);
+		Float32 fKval = drow::FastMath::tan(fOmega);
 		Float32 fKvalsq = fKval * fKval;
 		Float32 fRootTwo = sqrt(2.0);
 		Float32 ffrac = 1.0 / (1.0 + fRootTwo * fKval + fKvalsq);
@@ -129,8 +185,8 @@ public:
         
 		Float32 fOmegaA = M_PI * (centre/fSampleRate);
 		Float32 fOmegaB = M_PI * (bandwidth/fSampleRate);
-		Float32 fCval = (tan(fOmegaB) - 1) / (tan(2.0 * fOmegaB) + 1);
-		Float32 fDval = -1.0 * cos(2.0 * fOmegaA);
+		Float32 fCval = (drow::FastMath::tan(fOmegaB) - 1) / (drow::FastMath::tan(2.0 * fOmegaB) + 1);
+		Float32 fDval = -1.0 * drow::FastMath::cos(2.0 * fOmegaA);
 		
 		setB0(-1.0 * fCval);
 		setB1(fDval * (1.0 - fCval));
@@ -291,7 +347,7 @@ public:
     void setTarget(Point& point, float time = 0.0){
         this->time = time;
         stk::Envelope::setTarget(point.y);
-        stk::Envelope::setRate(fabs(point.y - value_) / ((point.x - time) * Stk::sampleRate()));
+        stk::Envelope::setRate(fabs(point.y - value_) * timeInc / (point.x - time)); // (timeInc = 1 / the sample rate)
     }
     
     float tick(){
@@ -345,18 +401,42 @@ typedef float (*Function)(float x);
 class Wavetable : public stk::FileLoop
 {
 public:
-    Wavetable() : fBaseFrequency(261.626) {}
+    Wavetable() : fBaseFrequency(261.626), tableSize(0) {}
     
+    // Opens a file from the plugin's Resources folder. The decoded table is shared
+    // (read-only) with every other Wavetable that opens the same resource.
     void openResource(std::string filename){
-        CFBundleRef plugBundle = CFBundleGetBundleWithIdentifier(CFSTR("com.UWE.TestSynthAU"));
-        CFURLRef resourcesURL = CFBundleCopyResourcesDirectoryURL(plugBundle);
-        char path[PATH_MAX];
-        CFURLGetFileSystemRepresentation(resourcesURL, TRUE, (UInt8 *)path, PATH_MAX);
-        CFRelease(resourcesURL);
+        SharedTable::Ptr resource = ResourceCache::getInstance()->openResource(filename);
+        if(resource == nullptr){
+            openFile(getResourcePath(filename)); // report the error, as before
+            normalize();
+            return;
+        }
         
-        openFile(std::string(path) + "/" + filename);
-        normalize();
+        closeFile();
+        table = resource;
+        tableSize = table->getFileSize();
+        chunking_ = false;
+        data_.resize(0, table->getChannels());
+        lastFrame_.resize(1, table->getChannels());
+        setRate(table->getDataRate() / Stk::sampleRate());
+        reset();
     }
+    
+    void openFile(std::string fileName, bool raw = false, bool doNormalize = true){
+        table = nullptr;
+        FileLoop::openFile(fileName, raw, doNormalize);
+        tableSize = file_.fileSize();
+    }
+    
+    void closeFile(){
+        table = nullptr;
+        tableSize = 0;
+        FileLoop::closeFile();
+    }
+    
+    unsigned long getSize() const { return table ? table->getFrames() : FileLoop::getSize(); }
+    stk::StkFloat getFileRate() const { return table ? table->getDataRate() : FileLoop::getFileRate(); }
         
     void setFrequency( float frequency ) {
         setRate( frequency / fBaseFrequency);
@@ -368,52 +448,60 @@ public:
     
     virtual float tick(){
         interpolate_ = true;
-        return FileLoop::tick();
+        return chunking_ ? FileLoop::tick() : tickTable(true);
     }
     
     virtual float tick(float phase){
         interpolate_ = true;
-        time_ = phase * file_.fileSize();
-        return FileLoop::tick();
+        time_ = phase * tableSize;
+        return chunking_ ? FileLoop::tick() : tickTable(true);
     }
     
     Wavetable& operator=(const Wavetable& in){
+        if(this == &in)
+            return *this;
+        
+        // Shared tables are read-only, so just take another reference (no copying).
+        if(in.table){
+            closeFile();
+            table = in.table;
+            tableSize = in.tableSize;
+            chunking_ = false;
+            lastFrame_.resize(1, table->getChannels());
+            this->setRate(table->getDataRate() / Stk::sampleRate());
+            this->reset();
+            fBaseFrequency = in.fBaseFrequency;
+            return *this;
+        }
+        
         // Call close() in case another file is already open.
         this->closeFile();
         
-        // Attempt to open the file ... an error might be thrown here.
+        // The table may have been generated, distorted or copied from a shared one, so
+        // its file is closed - take the sizes from the table itself, not from the file.
         file_ = in.file_;
+        tableSize = in.tableSize;
+        chunking_ = in.chunking_;
         
-        // Determine whether chunking or not.
-        if ( in.file_.fileSize() > chunkThreshold_ ) {
-            chunking_ = in.chunking_;
+        if ( chunking_ ) {
             chunkPointer_ = in.chunkPointer_;
-            data_.resize( in.chunkSize_ + 1, in.file_.channels() );
             normalizing_ = in.normalizing_;
         }
-        else {
-            chunking_ = false;
-            data_.resize( in.file_.fileSize() + 1, in.file_.channels() );
-        }
         
-        // Load all or part of the data.
+        // Copy all or part of the data (including the wrap-around frame, if not chunking).
         data_ = in.data_;
+        data_.setDataRate( in.data_.dataRate() );
         
         if ( chunking_ ) { // If chunking, save the first sample frame for later.
             firstFrame_.resize( 1, data_.channels() );
             for ( unsigned int i=0; i<data_.channels(); i++ )
                 firstFrame_[i] = data_[i];
         }
-        else {  // If not chunking, copy the first sample frame to the last.
-            for ( unsigned int i=0; i<data_.channels(); i++ )
-                data_( data_.frames() - 1, i ) = data_[i];
-        }
         
         // Resize our lastOutputs container.
-        lastFrame_.resize( 1, in.file_.channels() );
-        
-        // Set default rate based on file sampling rate.
+        lastFrame_.resize( 1, in.data_.channels() );
         
+        // Set default rate based on the table's sampling rate.
         this->setRate( in.data_.dataRate() / Stk::sampleRate() );
         this->reset();
         
@@ -424,12 +512,13 @@ public:
     
     Wavetable& operator=(const Envelope& envelope){
         openResource("Silence.wav");
+        makeUnique();
         
         int iEnvLength = envelope.getLength();
         if(!iEnvLength)
             return *this;
 
-        int waveLength = file_.fileSize();
+        int waveLength = tableSize;
         
         Envelope new_envelope = envelope;
         new_envelope.resize(waveLength);
@@ -449,7 +538,9 @@ public:
     }
         
     void distort(Function function){
-        float waveLength = file_.fileSize();
+        makeUnique();
+        
+        float waveLength = tableSize;
         float* pSample = &data_[0];
         int nbChannels = data_.channels();
         
@@ -464,8 +555,8 @@ public:
         time_ = samples;
         
         if ( time_ < 0.0 ) time_ = 0.0;
-        if ( time_ > file_.fileSize() - 1.0 ) {
-            time_ = file_.fileSize() - 1.0;
+        if ( time_ > tableSize - 1.0 ) {
+            time_ = tableSize - 1.0;
             for ( unsigned int i=0; i<lastFrame_.size(); i++ ) lastFrame_[i] = 0.0;
             finished_ = true;
         }
@@ -473,7 +564,9 @@ public:
     
     void generate(Function function){
         openResource("Silence.wav");
-        float waveLength = file_.fileSize();
+        makeUnique();
+        
+        float waveLength = tableSize;
         
         float* pSample = &data_[0];
         int nbChannels = data_.channels();
@@ -487,8 +580,70 @@ public:
         setBaseFrequency(getSampleRate()/waveLength);
     }
     
+protected:
+    // Reads the (unchunked) table, whether shared or private
+    float tickTable(bool loop){
+        const stk::StkFloat* pData = table ? table->getData() : &data_[0];
+        const unsigned int nbChannels = lastFrame_.channels();
+        const stk::StkFloat fileSize = tableSize;
+        
+        if(loop){
+            while ( time_ < 0.0 )
+                time_ += fileSize;
+            while ( time_ >= fileSize )
+                time_ -= fileSize;
+        }else if(finished_ || time_ < 0.0 || time_ > fileSize - 1.0){
+            for ( unsigned int i=0; i<lastFrame_.size(); i++ ) lastFrame_[i] = 0.0;
+            finished_ = true;
+            return 0.0;
+        }
+        
+        stk::StkFloat tyme = time_;
+        if ( loop && phaseOffset_ ) {
+            tyme += phaseOffset_;
+            while ( tyme < 0.0 )
+                tyme += fileSize;
+            while ( tyme >= fileSize )
+                tyme -= fileSize;
+        }
+        
+        const unsigned long index = (unsigned long) tyme;
+        const stk::StkFloat* pFrame = pData + index * nbChannels;
+        
+        if ( interpolate_ ) {
+            const stk::StkFloat alpha = tyme - index;
+            for ( unsigned int c=0; c<nbChannels; c++ )
+                lastFrame_[c] = pFrame[c] + alpha * (pFrame[c + nbChannels] - pFrame[c]);
+        }
+        else {
+            for ( unsigned int c=0; c<nbChannels; c++ )
+                lastFrame_[c] = pFrame[c];
+        }
+        
+        // Increment time, which can be negative.
+        time_ += rate_;
+        
+        return lastFrame_[0];
+    }
+    
+    // Takes a private copy of a shared table, before it is modified
+    void makeUnique(){
+        if(!table)
+            return;
+        
+        SharedTable::Ptr shared = table;
+        table = nullptr;
+        
+        data_.resize(shared->getFrames(), shared->getChannels());
+        data_.setDataRate(shared->getDataRate());
+        memcpy(&data_[0], shared->getData(), sizeof(stk::StkFloat) * data_.size());
+    }
+    
+    SharedTable::Ptr table;
+    
 private:
     float fBaseFrequency;
+    unsigned long tableSize;
 };
         
 
@@ -496,7 +651,7 @@ class Buffer : public Wavetable
 {
 public:
     float tick(){
-        return stk::FileWvIn::tick();
+        return chunking_ ? stk::FileWvIn::tick() : tickTable(false);
     }
     
     float getDuration() const {
@@ -506,19 +661,12 @@ public:
     
 } // namespace APDI
 
-//==============================================================================
-/** A simple synth sound ... */
-class SimpleSound : public SynthesiserSound
-{
-public:
-    SimpleSound() {}
-    
-    bool appliesToNote (const int /*midiNoteNumber*/)           { return true; }
-    bool appliesToChannel (const int /*midiChannel*/)           { return true; }
-};
+#include "PluginStreaming.h"
 
 class MySynth;
 
+template <int ID> struct Parameter; // (see SynthEditor.h)
+
 class IPluginParameters
 {
 public:
@@ -527,10 +675,31 @@ public:
     virtual int getNumParameters() const = 0;
     virtual float getParameter (int index) const = 0;
     virtual void setParameter (int index, float newValue) = 0;
+    virtual float getValue (int index) const = 0;     // scaled and smoothed, for the voices (audio thread only)
     virtual const String getParameterName (int index) const = 0;
     virtual const String getParameterText (int index) const = 0;
 };
 
+//==============================================================================
+/** A simple synth sound - either for all MIDI channels (channel 0), or for one channel
+    with its own set of parameters (used by the synth's multitimbral mode) */
+class SimpleSound : public SynthesiserSound
+{
+public:
+    SimpleSound(int channel = 0, IPluginParameters* parameters = NULL)
+    :   iChannel(channel), pParameters(parameters) {}
+    
+    bool appliesToNote (const int /*midiNoteNumber*/)           { return true; }
+    bool appliesToChannel (const int midiChannel)               { return iChannel == 0 || iChannel == midiChannel; }
+    
+    int getChannel() const { return iChannel; }
+    IPluginParameters* getParameters() const { return pParameters; }
+    
+private:
+    int iChannel;
+    IPluginParameters* pParameters;
+};
+
 //==============================================================================
 /** An (abstract) class for an STK-based synthesized voice (can be hidden from students) */
 class Voice  : public SynthesiserVoice
@@ -550,17 +719,27 @@ public:
     float getParameter(int index){ return pParameters->getParameter(index); }
     void setParameter(int index, float value){ pParameters->setParameter(index, value); }
     
+    // A parameter's value as set by its Scale in UI_CONTROLS, as its control's type (e.g. a bool for a TOGGLE)
+    // - for example: const float fCutoff = getValue<kParam3>();
+    template <int ID>
+    typename Parameter<ID>::Type getValue(){ return (typename Parameter<ID>::Type) pParameters->getValue(Parameter<ID>::index); }
+    
     virtual bool canPlaySound (SynthesiserSound* sound)
     {
         return dynamic_cast <SimpleSound*> (sound) != 0;
     }
     
     virtual void startNote (const int midiNoteNumber, const float velocity,
-                            SynthesiserSound* /*sound*/, const int /*currentPitchWheelPosition*/)
+                            SynthesiserSound* sound, const int /*currentPitchWheelPosition*/)
     {
         level = 1.0;//velocity * 0.5;
         tailOff = 0.0;
         
+        // in multitimbral mode, play with the parameters of the note's channel
+        SimpleSound* simpleSound = dynamic_cast <SimpleSound*> (sound);
+        if(simpleSound && simpleSound->getParameters())
+            pParameters = simpleSound->getParameters();
+        
         onStartNote(midiNoteNumber, velocity);
         bSilent = false;
     }
@@ -606,9 +785,18 @@ public:
         
         if (!bSilent)
         {
-            buffer.setSize (numChannels, bufferSize, false, false, true);
+            // render into the plugin instance's scratch memory (or the voice's own buffer, if there isn't enough)
+            APDI::Context::ScratchScope scratch (APDI::Context::getCurrent());
+            float* scratchChannels[APDI::Context::kScratchChannels];
+            float** channels = scratchChannels;
             
-            if(!process (buffer.getArrayOfChannels(), numChannels, numSamples))
+            if (numChannels > APDI::Context::kScratchChannels || !scratch.allocate (scratchChannels, numChannels, bufferSize))
+            {
+                buffer.setSize (numChannels, bufferSize, false, false, true);
+                channels = buffer.getArrayOfChannels();
+            }
+            
+            if(!process (channels, numChannels, numSamples))
             {
                 clearCurrentNote();
                 tailOff = 0.0f;
@@ -620,7 +808,7 @@ public:
                 for (int i = 0; i < numSamples; ++i)
                 {
                     for(int c=0; c<numChannels; c++)
-                        *buffer.getSampleData (c, i) *= level * tailOff;
+                        channels[c][i] *= level * tailOff;
                     
                     tailOff *= 0.99;
                     
@@ -637,12 +825,12 @@ public:
                 for (int i = 0; i < numSamples; ++i)
                 {
                     for(int c=0; c<numChannels; c++)
-                        *buffer.getSampleData (c, i) *= level;
+                        channels[c][i] *= level;
                 }
             }
             
             for(int c=0; c< outputBuffer.getNumChannels(); c++)
-                outputBuffer.addFrom(c, startSample, buffer, c, 0, bufferSize);
+                outputBuffer.addFrom(c, startSample, channels[c], bufferSize);
         }
     }
     virtual bool process (float** outputBuffer, int numChannels, int numSamples) = 0;
@@ -658,4 +846,147 @@ private:
     MySynth* pSynth;
 };
 
+//==============================================================================
+/** A voice that strikes a 2-D waveguide mesh, sized from the note's pitch (as a drum).
+    Meshes are capped at maxSize x maxSize junctions, so each voice costs no more than
+    one mesh of that size per sample. Notes too low for that size (below about fs / 181
+    for the default 64 x 64, i.e. 244Hz at 44.1kHz) are raised by octaves until they fit.
+    Notes are left to ring out when released, and end once the mesh has rung out.
+    Override onStartNote() to set up the mesh differently (calling strike() to play it). */
+class MeshVoice : public Voice
+{
+public:
+    MeshVoice(int maxSize = APDI::Mesh::MAX_SIZE)
+    :   iMaxSize(jlimit(2, (int)APDI::Mesh::MAX_SIZE, maxSize))
+    {
+    }
+    
+    virtual void onStartNote(const int midiNoteNumber, const float velocity)
+    {
+        // an N x N mesh's fundamental is about fs / (2 sqrt(2) N)
+        const double sizeOfOneHertz = APDI::getSampleRate() / (2.0 * std::sqrt(2.0));
+        double frequency = drow::FastMath::midiNoteToHertz(midiNoteNumber);
+        
+        // (so that low notes keep their pitch class, rather than all sounding the same)
+        while(sizeOfOneHertz / frequency > iMaxSize + 0.5)
+            frequency *= 2.0;
+        
+        strike(roundToInt(sizeOfOneHertz / frequency), velocity);
+    }
+    
+    // (let the mesh ring out, rather than fading it out - process() ends the note)
+    virtual bool onStopNote() { return false; }
+    
+    virtual bool process(float** outputBuffer, int numChannels, int numSamples)
+    {
+        mesh.tick(outputBuffer[0], numSamples);
+        for(int c=1; c<numChannels; c++)
+            FloatVectorOperations::copy(outputBuffer[c], outputBuffer[0], numSamples);
+        
+        return mesh.energy() > 1.0e-6f;
+    }
+    
+protected:
+    /** Clears the mesh, resizes it (capped at the voice's maximum) and strikes it. */
+    void strike(int size, float amplitude, float position = 0.3f)
+    {
+        size = jlimit(2, iMaxSize, size);
+        mesh.clear();
+        mesh.setNX(size);
+        mesh.setNY(size);
+        mesh.setInputPosition(position, position);
+        mesh.noteOn(0, amplitude);
+    }
+    
+    APDI::Mesh mesh;
+    
+private:
+    const int iMaxSize;
+};
+
+//==============================================================================
+/** A voice that plays an STK instrument (e.g. InstrumentVoice<stk::Clarinet>), passing it
+    notes, pitch bends (of up to 2 semitones) and controllers (using the STK's controller
+    numbers). The instrument is rendered in blocks, calling its own tick(StkFrames&) directly
+    rather than through the stk::Instrmnt interface. Notes are left to ring out when released,
+    and end once the instrument has fallen silent (see APDI::SilenceDetector), which frees
+    percussive voices as soon as they're inaudible, even if still held.
+    (Instruments that load the STK's rawwaves need stk::Stk::setRawwavePath() to be set.) */
+template <class InstrumentType>
+class InstrumentVoice : public Voice
+{
+public:
+    enum { kBlockSize = 256 };
+    
+    InstrumentVoice()
+    :   frames(kBlockSize, instrument.channelsOut()), fFrequency(440.0f)
+    {
+    }
+    
+    // for instruments constructed with an argument (e.g. a lowest frequency)
+    template <typename ArgumentType>
+    explicit InstrumentVoice(ArgumentType argument)
+    :   instrument(argument), frames(kBlockSize, instrument.channelsOut()), fFrequency(440.0f)
+    {
+    }
+    
+    virtual void onStartNote(const int midiNoteNumber, const float velocity)
+    {
+        fFrequency = drow::FastMath::midiNoteToHertz(midiNoteNumber);
+        silence.reset();
+        instrument.noteOn(fFrequency, velocity);
+    }
+    
+    virtual bool onStopNote()
+    {
+        instrument.noteOff(0.5);
+        return false;   // (the note ends when the instrument falls silent)
+    }
+    
+    virtual void onPitchWheel(const int value)
+    {
+        const float fSemitones = (value - 8192) * (2.0f / 8192.0f);
+        instrument.setFrequency(fFrequency * drow::FastMath::exp2(fSemitones / 12.0f));
+    }
+    
+    virtual void onControlChange(const int controller, const int value)
+    {
+        instrument.controlChange(controller, (stk::StkFloat)value);
+    }
+    
+    virtual bool process(float** outputBuffer, int numChannels, int numSamples)
+    {
+        const int numInstrumentChannels = frames.channels();
+        
+        for(int start = 0; start < numSamples; start += kBlockSize)
+        {
+            const int count = jmin((int)kBlockSize, numSamples - start);
+            frames.resize(count, numInstrumentChannels);    // (never larger, so never reallocates)
+            instrument.InstrumentType::tick(frames);
+            
+            for(int c=0; c<numChannels; c++)
+            {
+                const int channel = jmin(c, numInstrumentChannels - 1);
+                float* pfOut = outputBuffer[c] + start;
+                
+                if(numInstrumentChannels == 1)
+                    FloatVectorOperations::copy(pfOut, &frames[0], count);
+                else
+                    for(int i=0; i<count; i++)
+                        pfOut[i] = frames(i, channel);
+            }
+        }
+        
+        return !silence.process(outputBuffer[0], numSamples);
+    }
+    
+protected:
+    InstrumentType instrument;
+    
+private:
+    stk::StkFrames frames;
+    APDI::SilenceDetector silence;
+    float fFrequency;
+};
+
 #endif
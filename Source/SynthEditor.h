@@ -17,11 +17,35 @@ enum CONTROL_TYPE
     MENU,   // drop-down list (menu)
 };
 
-typedef Rectangle<int> Bounds;
+// The position and size of a control (a Rectangle<int> that can be used in the constant UI_CONTROLS)
+struct Bounds
+{
+    constexpr Bounds(int x, int y, int width, int height) : x(x), y(y), width(width), height(height) {}
+    
+    operator Rectangle<int>() const { return Rectangle<int>(x, y, width, height); }
+    bool operator== (const Bounds& other) const { return x == other.x && y == other.y && width == other.width && height == other.height; }
+    
+    int x, y, width, height;
+};
+
+// How the synth sees a parameter's (0.0-1.0) value: scaled to the range from-to, with a skew
+// (1 = linear, 2 = squared, etc. for more resolution at the low end), and smoothed over a
+// time (in seconds) when it changes, to avoid clicks (0 = no smoothing). See Voice::getValue().
+struct Scale
+{
+    constexpr Scale(float from = 0.0f, float to = 1.0f, float skew = 1.0f, float smoothing = 0.0f)
+    :   from(from), to(to), skew(skew), smoothing(smoothing) {}
+    
+    float operator() (float value) const {
+        return from + (to - from) * (skew == 1.0f ? value : std::pow(value, skew));
+    }
+    
+    float from, to, skew, smoothing;
+};
 
 struct Control
 {
-    String name;            // name for control label / saved parameter
+    const char* name;       // name for control label / saved parameter
     int parameter;          // parameter index associated with control
     CONTROL_TYPE type;      // control type (see above)
     
@@ -33,10 +57,13 @@ struct Control
     
     Bounds size;            // position (x,y) and size (height, width) of the control (use AUTO_SIZE for automatic layout)
     
+    Scale scale;            // how the synth's voices see the value (leave out, or use UNSCALED, to see it as it is)
+    
     const char* const options[8]; // text options for menus and group buttons
 };
 
-const Bounds AUTO_SIZE = Bounds(-1,-1,-1,-1); // used to trigger automatic layout
+constexpr Bounds AUTO_SIZE = Bounds(-1,-1,-1,-1); // used to trigger automatic layout
+constexpr Scale UNSCALED = Scale();
 enum { kParam0, kParam1, kParam2, kParam3, kParam4, kParam5, kParam6, kParam7, kParam8, kParam9, kParam10, kParam11, kParam12, kParam13 };
 
 //=========================================================================
@@ -48,13 +75,16 @@ enum { kParam0, kParam1, kParam2, kParam3, kParam4, kParam5, kParam6, kParam7, k
 // - for rotary and linear sliders, you can set the range of values
 // - by default, the controls are laid out in a grid, but you can also move and size them manually
 //   i.e. replace AUTO_SIZE with Bounds(50,50,100,100) to place a 100x100 control at (50,50)
+// - each parameter's value can also be scaled (and smoothed) for the voices by adding a scale
+//   after the size, e.g. Scale(20, 20000, 2, 0.05) scales it to 20-20000, squared, gliding to
+//   new values over 50ms
 
-const Control UI_CONTROLS[] = {
-//      name,       parameter,  type,   min, max, initial,size          // options (for MENU)
-    {   "LFO Rate",  kParam0,    ROTARY, 0.0, 1.0, 0.25,    AUTO_SIZE   },
+constexpr Control UI_CONTROLS[] = {
+//      name,       parameter,  type,   min, max, initial,size          // scale (for the voices), options (for MENU)
+    {   "LFO Rate",  kParam0,    ROTARY, 0.0, 1.0, 0.25,    AUTO_SIZE,  Scale(0.1, 20.0)    },
     {   "Mod Type",  kParam1,    TOGGLE, 0.0, 1.0, 0.0,    AUTO_SIZE   },
     {   "Tuning",  kParam2,    ROTARY, 0.0, 1.0, 0.5,    AUTO_SIZE   },
-    {   "LPFilter",  kParam3,    ROTARY, 0.0, 1.0, 0.75,    AUTO_SIZE   },
+    {   "LPFilter",  kParam3,    ROTARY, 0.0, 1.0, 0.75,    AUTO_SIZE,  Scale(20, 19020)    },
     {   "Out Gain",  kParam4,    ROTARY, 0.0, 1.0, 0.5,    AUTO_SIZE   },
     
 
@@ -74,4 +104,41 @@ const Control UI_CONTROLS[] = {
 const int kNumberOfControls = sizeof(UI_CONTROLS) / sizeof(Control);
 const int kNumberOfParameters = kNumberOfControls;
 
+// The type of value a voice sees for each kind of control (see Voice::getValue())
+template <CONTROL_TYPE type> struct ControlValue     { typedef float Type; };
+template <> struct ControlValue<TOGGLE>              { typedef bool Type; };
+template <> struct ControlValue<MENU>                { typedef int Type; };
+
+// A parameter's identifier, as a type - e.g. Parameter<kParam1>::Type is bool, as kParam1 is a TOGGLE
+template <int ID>
+struct Parameter
+{
+    static_assert (ID >= 0 && ID < kNumberOfParameters, "no such parameter");
+    static_assert (UI_CONTROLS[ID].parameter == ID, "UI_CONTROLS must list the parameters in order");
+    
+    enum { index = ID };
+    typedef typename ControlValue<UI_CONTROLS[ID].type>::Type Type;
+};
+
+struct Preset
+{
+    const char* name;                   // name of the program, as shown by the host
+    float values[kNumberOfParameters];  // a value for each parameter (in the same order as UI_CONTROLS)
+};
+
+//=========================================================================
+// UI_PRESETS - Use this array to add programs (presets) to your plugin
+// - the "Default" program (using the initial values above) is always the first program
+// - each preset lists the value of every parameter, in the same order as UI_CONTROLS
+// - hosts can switch between programs instantly, or morph smoothly from one to another
+
+const Preset UI_PRESETS[] = {
+//      name,           LFO Rate, Mod Type, Tuning, LPFilter, Out Gain, LFO Depth, -----, Richness, AM Mod, Release, Attack, Decay, Sustain, Dry/Wet
+    {   "Soft Pad",     { 0.1,      0.0,      0.5,    0.4,      0.5,      0.3,       0.0,   0.2,      0.0,    0.6,     0.5,    0.5,   0.8,     0.5 }   },
+    {   "Bright Lead",  { 0.25,     1.0,      0.75,   0.9,      0.5,      0.0,       0.0,   0.6,      0.0,    0.1,     0.01,   0.2,   0.7,     0.5 }   },
+    {   "Bell",         { 0.25,     1.0,      0.7,    0.8,      0.5,      0.0,       0.0,   0.4,      0.5,    0.8,     0.0,    1.0,   0.0,     0.5 }   },
+};
+
+const int kNumberOfPresets = sizeof(UI_PRESETS) / sizeof(Preset);
+
 #endif
@@ -62,13 +62,13 @@ Voice* JUCE_CALLTYPE createVoice() {
 // Triggered when a note is started (use to initialise / prepare note)
 void MyVoice::onStartNote (const int pitch, const float velocity)
 {
-    fCarrierFrequency = MidiMessage::getMidiNoteInHertz (pitch);
+    fCarrierFrequency = drow::FastMath::midiNoteToHertz (pitch);
     
     // retreving envelope parameters
-    float fAttack = getParameter(kParam10);
-    float fDecay = getParameter(kParam11);
-    float fSustain = getParameter(kParam12);
-    float fPan = getParameter(kParam13);
+    float fAttack = getValue<kParam10>();
+    float fDecay = getValue<kParam11>();
+    float fSustain = getValue<kParam12>();
+    float fPan = getValue<kParam13>();
     
     // resetter
     carrier1.reset();
@@ -94,7 +94,7 @@ void MyVoice::onStartNote (const int pitch, const float velocity)
 // Triggered when a note is stopped (return false to keep the note alive)
 bool MyVoice::onStopNote ()
 {
-    float fRelease = getParameter(kParam9) + 0.01;
+    float fRelease = getValue<kParam9>() + 0.01;
     ampEnv.release(fRelease);
     return false;
 }
@@ -108,13 +108,14 @@ bool MyVoice::process (float** outputBuffer, int numChannels, int numSamples)
     float* pfOutBuffer1 = outputBuffer[1];
     
     // declaration of local variables and their assignments + scaling
-    float fModFrequency = fCarrierFrequency * (getParameter(kParam2));
-    float fModIndex = (getParameter(kParam7) * 0.5) + 0.5;
-    float fOutGain = getParameter(kParam4);
-    bool modType = getParameter(kParam1);
-    float LFOrate = (getParameter(kParam0) * 19.9 + 0.1);
-    float fLFOdepth = getParameter(kParam5) * 0.2;
-    float fAMmodFrequency = (fCarrierFrequency * getParameter(kParam8))+20;
+    // (LFO Rate and LPFilter are scaled in UI_CONTROLS)
+    float fModFrequency = fCarrierFrequency * getValue<kParam2>();
+    float fModIndex = (getValue<kParam7>() * 0.5) + 0.5;
+    float fOutGain = getValue<kParam4>();
+    bool modType = getValue<kParam1>();
+    float LFOrate = getValue<kParam0>();
+    float fLFOdepth = getValue<kParam5>() * 0.2;
+    float fAMmodFrequency = (fCarrierFrequency * getValue<kParam8>())+20;
     const float fIfd = fModFrequency * fModIndex;
     float fMod, fLFO;
     
@@ -123,7 +124,7 @@ bool MyVoice::process (float** outputBuffer, int numChannels, int numSamples)
 
     // setting frequencies for the while loop
     LFO.setFrequency(LFOrate);
-    filter.setCutoff(getParameter(kParam3)*19000+20);
+    filter.setCutoff(getValue<kParam3>());
     modulator1.setFrequency(fModFrequency);
     modulator2.setFrequency(fModFrequency);
     modulator3.setFrequency(fAMmodFrequency);